@@ -0,0 +1,207 @@
+/*
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Differential check for the amalgamated classifier.
+ *
+ * Classifies a large number of synthetic flows using both the normal
+ * dispatch tables and the classifier generated by gen_amalgamation.sh, and
+ * complains about any flow where the two disagree. The payloads, sizes and
+ * ports for the flows are mostly taken from the values that the modules 
+ * themselves look for (see amalgamation_corpus.h), mixed with some random
+ * values, so that a good number of flows get past the first few checks in
+ * each rule.
+ *
+ * Run using 'make amalgamation-check'.
+ */
+
+#define __STDC_FORMAT_MACROS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <arpa/inet.h>
+
+#include "libprotoident.h"
+#include "proto_common.h"
+#include "lpi_amalgamated.h"
+#include "amalgamation_corpus.h"
+
+#define CORPUS_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint32_t rnd(void) {
+
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return (uint32_t)rng_state;
+}
+
+static uint32_t random_word(void) {
+
+	uint8_t b[4];
+	uint32_t word;
+	uint32_t r = rnd() % 10;
+	int i;
+
+	if (r < 5) {
+		const int *w = corpus_words[rnd() % CORPUS_SIZE(corpus_words)];
+		for (i = 0; i < 4; i++)
+			b[i] = (w[i] == ANY) ? rnd() : w[i];
+	} else if (r < 7) {
+		const char *s = corpus_strings[rnd() % 
+				CORPUS_SIZE(corpus_strings)];
+		memset(b, 0, 4);
+		memcpy(b, s, strlen(s) < 4 ? strlen(s) : 4);
+	} else if (r < 9) {
+		word = rnd();
+		memcpy(b, &word, 4);
+	} else {
+		memset(b, 0, 4);
+	}
+
+	/* Occasionally corrupt a byte, to catch rules that are one octet 
+	 * away from matching */
+	if (rnd() % 8 == 0)
+		b[rnd() % 4] = rnd();
+
+	memcpy(&word, b, 4);
+	return word;
+}
+
+static uint32_t random_len(void) {
+
+	uint32_t r = rnd() % 10;
+
+	if (r < 2)
+		return 0;
+	if (r < 7)
+		return corpus_lens[rnd() % CORPUS_SIZE(corpus_lens)];
+	if (r < 8)
+		return corpus_lens[rnd() % CORPUS_SIZE(corpus_lens)] + 1;
+	return rnd() % 1500;
+}
+
+static uint16_t random_port(void) {
+
+	if (rnd() % 4 == 0)
+		return rnd() % 65536;
+	return corpus_ports[rnd() % CORPUS_SIZE(corpus_ports)];
+}
+
+static void random_flow(lpi_data_t *data) {
+
+	uint32_t r = rnd() % 100;
+	int dir;
+
+	lpi_init_data(data);
+
+	if (r < 48)
+		data->trans_proto = TRACE_IPPROTO_TCP;
+	else if (r < 98)
+		data->trans_proto = TRACE_IPPROTO_UDP;
+	else if (r < 99)
+		data->trans_proto = TRACE_IPPROTO_ICMP;
+	else
+		data->trans_proto = 47;
+
+	data->server_port = random_port();
+	data->client_port = random_port();
+
+	for (dir = 0; dir < 2; dir++) {
+		uint32_t len = random_len();
+		uint32_t word = random_word();
+
+		/* Short payloads are zero-padded by lpi_update_data() */
+		if (len == 0)
+			word = 0;
+		else if (len < 4)
+			word = htonl((ntohl(word) >> (8 * (4 - len))) << 
+					(8 * (4 - len)));
+
+		data->payload[dir] = word;
+		data->payload_len[dir] = len;
+		data->observed[dir] = len;
+		if (rnd() % 4 == 0)
+			data->observed[dir] += rnd() % 3000;
+	}
+
+	data->ips[0] = rnd();
+	data->ips[1] = rnd();
+	if (rnd() % 20 == 0) {
+		data->payload[0] = data->ips[rnd() % 2];
+		data->payload[1] = data->ips[rnd() % 2];
+	}
+}
+
+int main(int argc, char *argv[]) {
+
+	uint64_t flows = 2000000;
+	uint64_t i, mismatches = 0;
+	lpi_data_t data;
+
+	if (argc > 1)
+		flows = strtoull(argv[1], NULL, 10);
+
+	if (lpi_init_library() == -1)
+		return 1;
+
+	for (i = 0; i < flows; i++) {
+		lpi_module_t *expected, *got;
+
+		random_flow(&data);
+		expected = lpi_guess_protocol(&data);
+		got = lpi_amalgamated_guess(&data);
+
+		if (expected->protocol == got->protocol)
+			continue;
+
+		if (mismatches < 10) {
+			fprintf(stderr, "Mismatch: expected %s, got %s "
+				"(proto %u, ports %u %u, payload %08x %08x, "
+				"len %u %u)\n", expected->name, got->name, 
+				data.trans_proto, data.server_port, 
+				data.client_port, ntohl(data.payload[0]), 
+				ntohl(data.payload[1]), data.payload_len[0], 
+				data.payload_len[1]);
+		}
+		mismatches ++;
+	}
+
+	lpi_free_library();
+
+	printf("%" PRIu64 " flows checked, %" PRIu64 " mismatches\n", flows, 
+			mismatches);
+	return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,394 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libtrace.h>
+
+#include "libprotoident.h"
+#include "decap.h"
+
+/* The most tunnels we'll look inside for a single packet */
+#define LPI_DECAP_MAX_DEPTH 4
+
+#define GRE_FLAG_CHECKSUM 0x8000
+#define GRE_FLAG_ROUTING 0x4000
+#define GRE_FLAG_KEY 0x2000
+#define GRE_FLAG_SEQ 0x1000
+#define GRE_VERSION_MASK 0x0007
+
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_QINQ 0x88a8
+#define ETHERTYPE_TEB 0x6558		/* Transparent Ethernet Bridging */
+
+#define VXLAN_PORT 4789
+#define TEREDO_PORT 3544
+
+static uint32_t decap_mask = 0;
+static uint64_t decap_packets[LPI_ENCAP_LAST];
+
+static const char *encap_names[LPI_ENCAP_LAST] = {
+	"GRE",
+	"IPIP",
+	"VXLAN",
+	"Teredo"
+};
+
+/* A header that we are part way through parsing */
+typedef struct lpi_decap_layer {
+	const uint8_t *l3;
+	uint16_t ethertype;
+	uint32_t l3_rem;
+
+	const uint8_t *l4;
+	uint8_t proto;
+	uint32_t l4_rem;	/* Captured bytes from l4 onwards */
+	uint32_t l4_len;	/* Bytes from l4 onwards, according to the
+				   IP header */
+} LPIDecapLayer;
+
+bool decap_enabled(void) {
+	return decap_mask != 0;
+}
+
+/* Finds the transport header for the IP header in the given layer. Returns
+ * false if there isn't one, e.g. because the packet is a later fragment */
+static bool find_transport(LPIDecapLayer *layer) {
+
+	const uint8_t *ptr = layer->l3;
+	uint32_t rem = layer->l3_rem;
+	uint32_t hlen, len;
+	uint8_t nxt;
+
+	if (layer->ethertype == TRACE_ETHERTYPE_IP) {
+		const libtrace_ip_t *ip = (const libtrace_ip_t *)ptr;
+
+		if (rem < sizeof(libtrace_ip_t) || ip->ip_v != 4)
+			return false;
+		hlen = ip->ip_hl * 4;
+		if (hlen < sizeof(libtrace_ip_t) || rem < hlen)
+			return false;
+		if ((ntohs(ip->ip_off) & 0x1fff) != 0)
+			return false;
+
+		len = ntohs(ip->ip_len);
+		layer->proto = ip->ip_p;
+		layer->l4 = ptr + hlen;
+		layer->l4_rem = rem - hlen;
+		layer->l4_len = len > hlen ? len - hlen : 0;
+		return true;
+	}
+
+	if (layer->ethertype != TRACE_ETHERTYPE_IPV6)
+		return false;
+
+	if (rem < sizeof(libtrace_ip6_t) || (ptr[0] >> 4) != 6)
+		return false;
+
+	nxt = ((const libtrace_ip6_t *)ptr)->nxt;
+	len = ntohs(((const libtrace_ip6_t *)ptr)->plen);
+	ptr += sizeof(libtrace_ip6_t);
+	rem -= sizeof(libtrace_ip6_t);
+
+	/* Skip over any extension headers */
+	for (;;) {
+		switch(nxt) {
+			case 0:		/* Hop-by-hop options */
+			case 43:	/* Routing */
+			case 60:	/* Destination options */
+				if (rem < 2)
+					return false;
+				hlen = (ptr[1] + 1) * 8;
+				break;
+			case 44:	/* Fragment */
+				if (rem < 8)
+					return false;
+				if ((ntohs(*(const uint16_t *)(ptr + 2)) & 
+						0xfff8) != 0)
+					return false;
+				hlen = 8;
+				break;
+			case 51:	/* Authentication header */
+				if (rem < 2)
+					return false;
+				hlen = (ptr[1] + 2) * 4;
+				break;
+			default:
+				layer->proto = nxt;
+				layer->l4 = ptr;
+				layer->l4_rem = rem;
+				layer->l4_len = len;
+				return true;
+		}
+		if (rem < hlen)
+			return false;
+		nxt = ptr[0];
+		ptr += hlen;
+		rem -= hlen;
+		len = len > hlen ? len - hlen : 0;
+	}
+}
+
+/* Sets the layer to the IP header following an Ethernet header, if there 
+ * is one */
+static bool skip_ethernet(LPIDecapLayer *layer, const uint8_t *ptr, 
+		uint32_t rem) {
+
+	uint16_t ethertype;
+
+	if (rem < 14)
+		return false;
+	ethertype = ntohs(*(const uint16_t *)(ptr + 12));
+	ptr += 14;
+	rem -= 14;
+
+	while (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) {
+		if (rem < 4)
+			return false;
+		ethertype = ntohs(*(const uint16_t *)(ptr + 2));
+		ptr += 4;
+		rem -= 4;
+	}
+
+	layer->l3 = ptr;
+	layer->l3_rem = rem;
+	layer->ethertype = ethertype;
+	return true;
+}
+
+static bool peel_gre(LPIDecapLayer *layer) {
+
+	const uint8_t *ptr = layer->l4;
+	uint32_t rem = layer->l4_rem;
+	uint16_t flags, ptype;
+	uint32_t hlen = 4;
+
+	if (rem < 4)
+		return false;
+
+	flags = ntohs(*(const uint16_t *)ptr);
+	ptype = ntohs(*(const uint16_t *)(ptr + 2));
+
+	/* Version 1 is PPTP, which carries PPP rather than IP */
+	if ((flags & GRE_VERSION_MASK) != 0 || (flags & GRE_FLAG_ROUTING))
+		return false;
+
+	if (flags & GRE_FLAG_CHECKSUM)
+		hlen += 4;
+	if (flags & GRE_FLAG_KEY)
+		hlen += 4;
+	if (flags & GRE_FLAG_SEQ)
+		hlen += 4;
+	if (rem < hlen)
+		return false;
+
+	ptr += hlen;
+	rem -= hlen;
+
+	switch(ptype) {
+		case TRACE_ETHERTYPE_IP:
+		case TRACE_ETHERTYPE_IPV6:
+			layer->l3 = ptr;
+			layer->l3_rem = rem;
+			layer->ethertype = ptype;
+			return true;
+		case ETHERTYPE_TEB:
+			return skip_ethernet(layer, ptr, rem);
+	}
+	return false;
+}
+
+static bool peel_vxlan(LPIDecapLayer *layer) {
+
+	const uint8_t *ptr = layer->l4 + sizeof(libtrace_udp_t);
+	uint32_t rem = layer->l4_rem - sizeof(libtrace_udp_t);
+
+	/* The I flag must be set for the VNI to be valid */
+	if (rem < 8 || (ptr[0] & 0x08) == 0)
+		return false;
+
+	return skip_ethernet(layer, ptr + 8, rem - 8);
+}
+
+static bool peel_teredo(LPIDecapLayer *layer) {
+
+	const uint8_t *ptr = layer->l4 + sizeof(libtrace_udp_t);
+	uint32_t rem = layer->l4_rem - sizeof(libtrace_udp_t);
+	uint32_t hlen;
+
+	/* The IPv6 packet may be preceded by an authentication header 
+	 * and/or an origin indication */
+	if (rem >= 4 && ptr[0] == 0x00 && ptr[1] == 0x01) {
+		hlen = 4 + ptr[2] + ptr[3] + 9;
+		if (rem < hlen)
+			return false;
+		ptr += hlen;
+		rem -= hlen;
+	}
+	if (rem >= 8 && ptr[0] == 0x00 && ptr[1] == 0x00) {
+		ptr += 8;
+		rem -= 8;
+	}
+
+	if (rem < sizeof(libtrace_ip6_t) || (ptr[0] >> 4) != 6)
+		return false;
+
+	layer->l3 = ptr;
+	layer->l3_rem = rem;
+	layer->ethertype = TRACE_ETHERTYPE_IPV6;
+	return true;
+}
+
+/* Removes the encapsulation from the transport payload of the given layer,
+ * if it is one we've been asked to remove. The layer is updated to 
+ * describe the encapsulated IP header */
+static bool peel(LPIDecapLayer *layer, lpi_encap_t *encap) {
+
+	const libtrace_udp_t *udp;
+
+	switch(layer->proto) {
+		case 4:		/* IPv4 in IP */
+		case 41:	/* IPv6 in IP */
+			if (!(decap_mask & LPI_ENCAP_MASK(LPI_ENCAP_IPIP)))
+				return false;
+			*encap = LPI_ENCAP_IPIP;
+			layer->ethertype = (layer->proto == 4) ? 
+				TRACE_ETHERTYPE_IP : TRACE_ETHERTYPE_IPV6;
+			layer->l3 = layer->l4;
+			layer->l3_rem = layer->l4_rem;
+			return true;
+		case 47:
+			if (!(decap_mask & LPI_ENCAP_MASK(LPI_ENCAP_GRE)))
+				return false;
+			*encap = LPI_ENCAP_GRE;
+			return peel_gre(layer);
+		case 17:
+			if (layer->l4_rem < sizeof(libtrace_udp_t))
+				return false;
+			udp = (const libtrace_udp_t *)layer->l4;
+
+			if ((decap_mask & LPI_ENCAP_MASK(LPI_ENCAP_VXLAN)) &&
+					ntohs(udp->dest) == VXLAN_PORT) {
+				*encap = LPI_ENCAP_VXLAN;
+				return peel_vxlan(layer);
+			}
+			if ((decap_mask & LPI_ENCAP_MASK(LPI_ENCAP_TEREDO)) &&
+					(ntohs(udp->dest) == TEREDO_PORT ||
+					ntohs(udp->source) == TEREDO_PORT)) {
+				*encap = LPI_ENCAP_TEREDO;
+				return peel_teredo(layer);
+			}
+			return false;
+	}
+	return false;
+}
+
+int lpi_decapsulate(libtrace_packet_t *packet, lpi_inner_t *inner) {
+
+	LPIDecapLayer layer, found;
+	lpi_encap_t encaps[LPI_DECAP_MAX_DEPTH];
+	lpi_encap_t encap;
+	int depth = 0, found_depth = 0, i;
+	uint32_t hlen = 0;
+
+	if (decap_mask == 0)
+		return 0;
+
+	layer.l3 = (const uint8_t *)trace_get_layer3(packet, &layer.ethertype,
+			&layer.l3_rem);
+	if (layer.l3 == NULL || !find_transport(&layer))
+		return 0;
+
+	/* Keep going until we run out of tunnels, remembering the innermost
+	 * layer that had something we can classify */
+	while (depth < LPI_DECAP_MAX_DEPTH && peel(&layer, &encap)) {
+		if (!find_transport(&layer))
+			break;
+		encaps[depth++] = encap;
+
+		if (layer.proto == TRACE_IPPROTO_TCP || 
+				layer.proto == TRACE_IPPROTO_UDP) {
+			found = layer;
+			found_depth = depth;
+		}
+	}
+
+	if (found_depth == 0)
+		return 0;
+
+	for (i = 0; i < found_depth; i++)
+		__atomic_add_fetch(&decap_packets[encaps[i]], 1, 
+				__ATOMIC_RELAXED);
+
+	if (found.proto == TRACE_IPPROTO_TCP) {
+		if (found.l4_rem >= sizeof(libtrace_tcp_t))
+			hlen = ((const libtrace_tcp_t *)found.l4)->doff * 4;
+	} else {
+		hlen = sizeof(libtrace_udp_t);
+	}
+
+	inner->l3 = found.l3;
+	inner->ethertype = found.ethertype;
+	inner->l4 = found.l4;
+	inner->proto = found.proto;
+	inner->l4_rem = found.l4_rem;
+	inner->payload_len = found.l4_len > hlen ? found.l4_len - hlen : 0;
+	
+	return found_depth;
+}
+
+int lpi_set_decapsulation(uint32_t mask) {
+
+	if (mask & ~((1U << LPI_ENCAP_LAST) - 1)) {
+		fprintf(stderr, "Unknown encapsulation in mask %x\n", mask);
+		return -1;
+	}
+	decap_mask = mask;
+	return 0;
+}
+
+const char *lpi_print_encap(lpi_encap_t encap) {
+
+	if ((int)encap < 0 || encap >= LPI_ENCAP_LAST)
+		return "Invalid_Encapsulation";
+	return encap_names[encap];
+}
+
+void lpi_get_decap_stats(lpi_decap_stats_t *stats) {
+
+	int i;
+
+	for (i = 0; i < LPI_ENCAP_LAST; i++)
+		stats->packets[i] = __atomic_load_n(&decap_packets[i], 
+				__ATOMIC_RELAXED);
+}
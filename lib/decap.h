@@ -0,0 +1,51 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Tunnel decapsulation.
+ *
+ * When decapsulation has been enabled using lpi_set_decapsulation(), 
+ * lpi_update_data() looks inside any of the selected tunnels and updates
+ * the LPI data using the innermost TCP or UDP packet instead of the 
+ * tunnel itself. The headers are walked in place -- nothing is copied.
+ */
+
+#ifndef DECAP_H_
+#define DECAP_H_
+
+#include <stdint.h>
+
+#include "libprotoident.h"
+
+/* Returns true if any encapsulations are to be removed */
+bool decap_enabled(void);
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Flow batches: the LPI data for many flows, stored as a structure of 
+ * arrays.
+ *
+ * The protocol rules and the packet parsing code all work on lpi_data_t,
+ * so a flow is copied into an lpi_data_t whenever one of those needs to
+ * look at it. The common case of a packet arriving once the first payload
+ * has been seen in that direction is handled without doing so.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libprotoident.h"
+#include "flow_ext.h"
+
+/* The number of flows that are copied out of the batch and classified
+ * together */
+#define LPI_FLOW_BATCH_CHUNK 64
+
+lpi_flow_batch_t *lpi_flow_batch_create(uint32_t size) {
+
+	lpi_flow_batch_t *batch;
+	uint8_t *block;
+	int i;
+
+	if (size == 0) {
+		fprintf(stderr, "Cannot create an empty LPI flow batch\n");
+		return NULL;
+	}
+
+	batch = (lpi_flow_batch_t *)calloc(1, sizeof(lpi_flow_batch_t));
+	if (batch == NULL) {
+		fprintf(stderr, "Unable to allocate memory for LPI flow batch\n");
+		return NULL;
+	}
+
+	/* All of the arrays live in a single block, largest members first
+	 * so that each array is suitably aligned */
+	block = (uint8_t *)calloc(size, 11 * sizeof(uint32_t) + 
+			2 * sizeof(uint16_t) + 5 * sizeof(uint8_t));
+	if (block == NULL) {
+		fprintf(stderr, "Unable to allocate memory for LPI flow batch\n");
+		free(batch);
+		return NULL;
+	}
+
+	batch->size = size;
+	batch->count = 0;
+
+	for (i = 0; i < 2; i++) {
+		batch->payload[i] = (uint32_t *)block;
+		block += size * sizeof(uint32_t);
+		batch->payload_len[i] = (uint32_t *)block;
+		block += size * sizeof(uint32_t);
+		batch->observed[i] = (uint32_t *)block;
+		block += size * sizeof(uint32_t);
+		batch->seqno[i] = (uint32_t *)block;
+		block += size * sizeof(uint32_t);
+		batch->ips[i] = (uint32_t *)block;
+		block += size * sizeof(uint32_t);
+	}
+
+	batch->ext_slot = (uint32_t *)block;
+	block += size * sizeof(uint32_t);
+
+	batch->server_port = (uint16_t *)block;
+	block += size * sizeof(uint16_t);
+	batch->client_port = (uint16_t *)block;
+	block += size * sizeof(uint16_t);
+	batch->trans_proto = block;
+	block += size;
+	batch->ip_version = block;
+	block += size;
+	batch->seen_syn = block;
+	block += size;
+	batch->hold_count[0] = block;
+	block += size;
+	batch->hold_count[1] = block;
+
+	return batch;
+}
+
+/* Returns any extended payload capture buffers held by the flows */
+static void release_flows(lpi_flow_batch_t *batch) {
+
+	lpi_data_t data;
+	uint32_t i;
+
+	for (i = 0; i < batch->count; i++) {
+		if (batch->ext_slot[i] == 0)
+			continue;
+		data.ext_slot = batch->ext_slot[i];
+		lpi_free_data(&data);
+		batch->ext_slot[i] = 0;
+	}
+}
+
+void lpi_flow_batch_destroy(lpi_flow_batch_t *batch) {
+
+	if (batch == NULL)
+		return;
+
+	release_flows(batch);
+
+	/* payload[0] is the start of the block */
+	free(batch->payload[0]);
+	free(batch);
+}
+
+static void init_flow(lpi_flow_batch_t *batch, uint32_t idx) {
+
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		batch->payload[i][idx] = 0;
+		batch->payload_len[i][idx] = 0;
+		batch->observed[i][idx] = 0;
+		batch->seqno[i][idx] = 0;
+		batch->ips[i][idx] = 0;
+		batch->hold_count[i][idx] = 0;
+	}
+	batch->ext_slot[idx] = 0;
+	batch->server_port[idx] = 0;
+	batch->client_port[idx] = 0;
+	batch->trans_proto[idx] = 0;
+	batch->ip_version[idx] = 0;
+	batch->seen_syn[idx] = 0;
+}
+
+int lpi_flow_batch_add(lpi_flow_batch_t *batch) {
+
+	if (batch->count >= batch->size)
+		return -1;
+
+	init_flow(batch, batch->count);
+	return batch->count++;
+}
+
+void lpi_flow_batch_clear(lpi_flow_batch_t *batch) {
+	
+	release_flows(batch);
+	batch->count = 0;
+}
+
+void lpi_flow_batch_load(lpi_flow_batch_t *batch, uint32_t idx,
+		lpi_data_t *data) {
+
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		data->payload[i] = batch->payload[i][idx];
+		data->payload_len[i] = batch->payload_len[i][idx];
+		data->observed[i] = batch->observed[i][idx];
+		data->seqno[i] = batch->seqno[i][idx];
+		data->ips[i] = batch->ips[i][idx];
+		data->seen_syn[i] = (batch->seen_syn[idx] & (1 << i)) != 0;
+		data->hold_count[i] = batch->hold_count[i][idx];
+	}
+	data->ip6 = NULL;
+	data->ext_slot = batch->ext_slot[idx];
+	data->server_port = batch->server_port[idx];
+	data->client_port = batch->client_port[idx];
+	data->trans_proto = batch->trans_proto[idx];
+	data->ip_version = batch->ip_version[idx];
+	data->version = LPI_DATA_VERSION;
+}
+
+void lpi_flow_batch_store(lpi_flow_batch_t *batch, uint32_t idx,
+		const lpi_data_t *data) {
+
+	int i;
+	uint8_t syn = 0;
+
+	for (i = 0; i < 2; i++) {
+		batch->payload[i][idx] = data->payload[i];
+		batch->payload_len[i][idx] = data->payload_len[i];
+		batch->observed[i][idx] = data->observed[i];
+		batch->seqno[i][idx] = data->seqno[i];
+		batch->ips[i][idx] = data->ips[i];
+		batch->hold_count[i][idx] = data->hold_count[i];
+		if (data->seen_syn[i])
+			syn |= (1 << i);
+	}
+	batch->seen_syn[idx] = syn;
+	batch->ext_slot[idx] = data->ext_slot;
+	batch->server_port[idx] = data->server_port;
+	batch->client_port[idx] = data->client_port;
+	batch->trans_proto[idx] = data->trans_proto;
+	batch->ip_version[idx] = data->ip_version;
+}
+
+int lpi_flow_batch_update(lpi_flow_batch_t *batch, uint32_t idx,
+		libtrace_packet_t *packet, uint8_t dir) {
+
+	lpi_data_t data;
+	int ret;
+
+	/* These two checks are the same ones that lpi_update_data() starts
+	 * with, and cover most packets in a long flow. Packet sizes have to
+	 * be recorded by lpi_update_data() though */
+	if (size_sequence_full(batch->ext_slot[idx])) {
+		if (batch->observed[dir][idx] > 32 * 1024)
+			return 0;
+
+		if (batch->trans_proto[idx] != 6 && 
+				batch->payload_len[dir][idx] != 0) {
+			batch->observed[dir][idx] += 
+					trace_get_payload_length(packet);
+			return 0;
+		}
+	}
+
+	lpi_flow_batch_load(batch, idx, &data);
+	ret = lpi_update_data(packet, &data, dir);
+	lpi_flow_batch_store(batch, idx, &data);
+
+	return ret;
+}
+
+static int guess_flow_batch(lpi_context_t *ctx, lpi_flow_batch_t *batch,
+		lpi_module_t **out) {
+
+	lpi_data_t data[LPI_FLOW_BATCH_CHUNK];
+	lpi_data_t *flows[LPI_FLOW_BATCH_CHUNK];
+	uint32_t first, n, i;
+	int ret;
+
+	for (first = 0; first < batch->count; first += n) {
+		n = batch->count - first;
+		if (n > LPI_FLOW_BATCH_CHUNK)
+			n = LPI_FLOW_BATCH_CHUNK;
+
+		for (i = 0; i < n; i++) {
+			lpi_flow_batch_load(batch, first + i, &data[i]);
+			flows[i] = &data[i];
+		}
+
+		if (ctx == NULL)
+			ret = lpi_guess_protocol_batch(flows, n, &out[first]);
+		else
+			ret = lpi_ctx_guess_batch(ctx, flows, n, &out[first]);
+		if (ret == -1)
+			return -1;
+	}
+
+	return 0;
+}
+
+int lpi_flow_batch_guess(lpi_flow_batch_t *batch, lpi_module_t **out) {
+	return guess_flow_batch(NULL, batch, out);
+}
+
+int lpi_ctx_flow_batch_guess(lpi_context_t *ctx, lpi_flow_batch_t *batch,
+		lpi_module_t **out) {
+	
+	if (ctx == NULL) {
+		fprintf(stderr, "No LPI context provided to lpi_ctx_flow_batch_guess\n");
+		return -1;
+	}
+	return guess_flow_batch(ctx, batch, out);
+}
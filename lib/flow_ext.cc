@@ -0,0 +1,328 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "libprotoident.h"
+#include "flow_ext.h"
+
+/* Number of slots in each slab */
+#define LPI_EXT_SLAB_SLOTS 4096
+
+/* Maximum number of slabs, which limits the pool to about 64 million 
+ * flows */
+#define LPI_EXT_MAX_SLABS 16384
+
+/* The header at the start of each slot. This is followed by the packet 
+ * sizes, then the payload for direction 0 and the payload for direction 1.
+ */
+typedef struct lpi_flow_ext {
+	uint32_t next_free;	/* Next free slot, if on the free list */
+	uint32_t size_dirs;	/* Bit n is the direction of packet n */
+	uint16_t size_count;	/* Number of packet sizes recorded */
+	uint16_t len[2];	/* Payload bytes captured in each direction */
+} LPIFlowExt;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Bytes captured per direction, zero if extended capture is disabled */
+static uint32_t capture_len = 0;
+
+/* Packet sizes recorded per flow, zero if size sequences are disabled */
+static uint32_t sequence_len = 0;
+
+static uint32_t slot_size = 0;
+
+static uint8_t *slabs[LPI_EXT_MAX_SLABS];
+static uint32_t slab_count = 0;
+static uint32_t free_head = 0;
+static uint32_t slots_used = 0;
+
+static inline LPIFlowExt *get_slot(uint32_t slot) {
+
+	slot -= 1;
+	return (LPIFlowExt *)(slabs[slot / LPI_EXT_SLAB_SLOTS] + 
+			(slot % LPI_EXT_SLAB_SLOTS) * slot_size);
+}
+
+static inline uint16_t *slot_sizes(LPIFlowExt *ext) {
+	return (uint16_t *)(ext + 1);
+}
+
+static inline uint8_t *slot_payload(LPIFlowExt *ext, uint8_t dir) {
+	return (uint8_t *)(slot_sizes(ext) + sequence_len) + dir * capture_len;
+}
+
+/* Adds another slab to the free list. Must be called with the pool lock
+ * held */
+static bool add_slab(void) {
+
+	uint8_t *slab;
+	uint32_t first, i;
+
+	if (slab_count == LPI_EXT_MAX_SLABS)
+		return false;
+
+	slab = (uint8_t *)malloc(LPI_EXT_SLAB_SLOTS * slot_size);
+	if (slab == NULL)
+		return false;
+
+	slabs[slab_count] = slab;
+	first = slab_count * LPI_EXT_SLAB_SLOTS + 1;
+	slab_count ++;
+
+	for (i = 0; i < LPI_EXT_SLAB_SLOTS; i++) {
+		LPIFlowExt *ext = get_slot(first + i);
+		
+		if (i == LPI_EXT_SLAB_SLOTS - 1)
+			ext->next_free = free_head;
+		else
+			ext->next_free = first + i + 1;
+	}
+	free_head = first;
+	return true;
+}
+
+static uint32_t alloc_slot(void) {
+
+	uint32_t slot = 0;
+	LPIFlowExt *ext;
+
+	pthread_mutex_lock(&pool_lock);
+	if (free_head != 0 || add_slab()) {
+		slot = free_head;
+		ext = get_slot(slot);
+		free_head = ext->next_free;
+		ext->size_dirs = 0;
+		ext->size_count = 0;
+		ext->len[0] = 0;
+		ext->len[1] = 0;
+		slots_used ++;
+	}
+	pthread_mutex_unlock(&pool_lock);
+
+	return slot;
+}
+
+/* Returns the slot for the given flow, allocating one if it doesn't have
+ * one already. Returns NULL if the pool is exhausted */
+static LPIFlowExt *flow_slot(lpi_data_t *data) {
+	
+	if (data->ext_slot == 0) {
+		data->ext_slot = alloc_slot();
+		if (data->ext_slot == 0)
+			return NULL;
+	}
+	return get_slot(data->ext_slot);
+}
+
+void capture_prefix(lpi_data_t *data, uint8_t dir, const uint8_t *payload,
+		uint32_t len) {
+
+	LPIFlowExt *ext;
+
+	if (capture_len == 0)
+		return;
+
+	/* We'll have to make do with the first four bytes */
+	if ((ext = flow_slot(data)) == NULL)
+		return;
+
+	if (len > capture_len)
+		len = capture_len;
+
+	memcpy(slot_payload(ext, dir), payload, len);
+	ext->len[dir] = len;
+}
+
+void record_packet_size(lpi_data_t *data, uint8_t dir, uint32_t psize) {
+
+	LPIFlowExt *ext;
+
+	if (sequence_len == 0)
+		return;
+
+	if ((ext = flow_slot(data)) == NULL)
+		return;
+
+	if (ext->size_count >= sequence_len)
+		return;
+
+	slot_sizes(ext)[ext->size_count] = psize > 0xffff ? 0xffff : psize;
+	if (dir)
+		ext->size_dirs |= (1U << ext->size_count);
+	ext->size_count ++;
+}
+
+bool size_sequence_full(uint32_t slot) {
+
+	if (sequence_len == 0)
+		return true;
+	if (slot == 0)
+		return false;
+	return get_slot(slot)->size_count >= sequence_len;
+}
+
+void lpi_free_data(lpi_data_t *data) {
+
+	LPIFlowExt *ext;
+
+	if (data->ext_slot == 0)
+		return;
+
+	/* The pool is never torn down while a flow still holds a slot, so
+	 * the slot must belong to the current pool */
+	pthread_mutex_lock(&pool_lock);
+	ext = get_slot(data->ext_slot);
+	ext->next_free = free_head;
+	free_head = data->ext_slot;
+	slots_used --;
+	pthread_mutex_unlock(&pool_lock);
+
+	data->ext_slot = 0;
+}
+
+uint32_t lpi_get_payload_prefix(lpi_data_t *data, uint8_t dir, 
+		const uint8_t **bytes) {
+
+	LPIFlowExt *ext;
+
+	if (data->ext_slot != 0 && capture_len != 0) {
+		ext = get_slot(data->ext_slot);
+		*bytes = slot_payload(ext, dir);
+		return ext->len[dir];
+	}
+
+	*bytes = (const uint8_t *)&data->payload[dir];
+	return data->payload_len[dir] < 4 ? data->payload_len[dir] : 4;
+}
+
+uint32_t lpi_get_size_sequence(lpi_data_t *data, lpi_packet_size_t *seq,
+		uint32_t max) {
+
+	LPIFlowExt *ext;
+	uint16_t *sizes;
+	uint32_t i;
+
+	if (data->ext_slot == 0 || sequence_len == 0)
+		return 0;
+
+	ext = get_slot(data->ext_slot);
+	sizes = slot_sizes(ext);
+
+	for (i = 0; i < ext->size_count && i < max; i++) {
+		seq[i].size = sizes[i];
+		seq[i].dir = (ext->size_dirs >> i) & 1;
+	}
+	return i;
+}
+
+/* Must be called with the pool lock held */
+static void free_slabs(void) {
+
+	uint32_t i;
+
+	for (i = 0; i < slab_count; i++)
+		free(slabs[i]);
+	slab_count = 0;
+	free_head = 0;
+}
+
+/* Changes the amount of extended state kept for each flow. The pool can 
+ * only be rebuilt while no flows are using it */
+static int resize_pool(uint32_t capture, uint32_t sequence) {
+
+	pthread_mutex_lock(&pool_lock);
+	if (slots_used != 0) {
+		pthread_mutex_unlock(&pool_lock);
+		fprintf(stderr, "Cannot change the extended flow state while flows are still using it\n");
+		return -1;
+	}
+
+	free_slabs();
+	capture_len = capture;
+	sequence_len = sequence;
+
+	/* Keep the slots four-byte aligned */
+	slot_size = (sizeof(LPIFlowExt) + sequence * sizeof(uint16_t) + 
+			2 * capture + 3) & ~3;
+	pthread_mutex_unlock(&pool_lock);
+
+	return 0;
+}
+
+int lpi_set_payload_capture(uint32_t bytes) {
+
+	if (bytes > LPI_MAX_PAYLOAD_CAPTURE) {
+		fprintf(stderr, "Cannot capture more than %u bytes of payload\n",
+				LPI_MAX_PAYLOAD_CAPTURE);
+		return -1;
+	}
+
+	/* The first four bytes are always kept in the LPI data anyway */
+	if (bytes <= 4)
+		bytes = 0;
+
+	return resize_pool(bytes, sequence_len);
+}
+
+int lpi_set_size_sequence(uint32_t packets) {
+
+	if (packets > LPI_MAX_SIZE_SEQUENCE) {
+		fprintf(stderr, "Cannot record more than %u packet sizes\n",
+				LPI_MAX_SIZE_SEQUENCE);
+		return -1;
+	}
+
+	return resize_pool(capture_len, packets);
+}
+
+void free_flow_ext_pool(void) {
+
+	/* Like resize_pool(), leave the pool alone if any flows are still 
+	 * using it. Their slots can still be released with lpi_free_data() 
+	 * and the pool will be reused if the library is initialised again */
+	pthread_mutex_lock(&pool_lock);
+	if (slots_used != 0) {
+		pthread_mutex_unlock(&pool_lock);
+		fprintf(stderr, "Not freeing the extended flow state while flows are still using it\n");
+		return;
+	}
+
+	free_slabs();
+	capture_len = 0;
+	sequence_len = 0;
+	pthread_mutex_unlock(&pool_lock);
+}
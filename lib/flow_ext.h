@@ -0,0 +1,75 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Extended per-flow state.
+ *
+ * Extended payload capture and packet size sequences both need more space
+ * than lpi_data_t has to spare, and both are disabled by default. When
+ * either is enabled, each flow that has seen some payload is given a slot 
+ * from a pool of buffers, which holds the extra state for both directions.
+ * Flows refer to their slot by number rather than by pointer (see ext_slot
+ * in lpi_data_t), which keeps lpi_data_t within a cache line. Slot zero 
+ * means the flow has no slot.
+ *
+ * The slots are carved out of slabs that are never moved or freed while
+ * the pool is in use, so a slot number can be turned into a pointer 
+ * without taking the lock. Only allocating and releasing slots needs it.
+ */
+
+#ifndef FLOW_EXT_H_
+#define FLOW_EXT_H_
+
+#include <stdint.h>
+
+#include "libprotoident.h"
+
+/* Copies the start of the payload for the given direction into the flow's
+ * slot, allocating one if necessary. Does nothing if extended capture is
+ * not enabled. */
+void capture_prefix(lpi_data_t *data, uint8_t dir, const uint8_t *payload,
+		uint32_t len);
+
+/* Adds a payload-bearing packet to the flow's packet size sequence, 
+ * allocating a slot if necessary. Does nothing if size sequences are not 
+ * enabled or the sequence is already full. */
+void record_packet_size(lpi_data_t *data, uint8_t dir, uint32_t psize);
+
+/* Returns true unless size sequences are enabled and the sequence for the
+ * flow using the given slot is not yet full */
+bool size_sequence_full(uint32_t slot);
+
+/* Frees all of the slabs in the pool and disables all extended state, 
+ * unless some flows are still holding slots -- in that case the pool is
+ * left as it is */
+void free_flow_ext_pool(void);
+
+#endif
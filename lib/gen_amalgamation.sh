@@ -0,0 +1,194 @@
+#!/bin/sh
+#
+# This file is part of libprotoident
+#
+# Generates lpi_amalgamated.cc: a single translation unit containing every
+# protocol module along with a classifier that tries each module's callback
+# directly, in the same order as the dispatch tables built by
+# lpi_init_library(). Because the callbacks are no longer reached through
+# function pointers, the compiler is free to inline them and share the work
+# done by common helpers such as match_ssl() and match_dns().
+#
+# The module list (and its order) is taken from register_tcp_protocols()
+# and register_udp_protocols() in proto_manager.cc, so there is nothing
+# extra to maintain when a module is added.
+#
+# Usage: gen_amalgamation.sh <lib source directory> > lpi_amalgamated.cc
+#        gen_amalgamation.sh -c <lib source directory> > amalgamation_corpus.h
+#
+# The -c option instead generates the payload words, payload sizes and 
+# ports mentioned in the module sources, which amalgamation_check uses to 
+# build flows that will actually exercise the rules.
+
+corpus=no
+if [ "$1" = "-c" ]; then
+	corpus=yes
+	shift
+fi
+
+srcdir=${1:-.}
+manager=$srcdir/proto_manager.cc
+
+if [ ! -f "$manager" ]; then
+	echo "gen_amalgamation.sh: cannot find $manager" >&2
+	exit 1
+fi
+
+# Prints the register functions called by the given function, in order
+list_modules() {
+	sed -n "/^int $1(/,/^}/p" "$manager" | \
+		sed -n 's/^[ 	]*\(register_[A-Za-z0-9_]*\)(mod_map);.*/\1/p'
+}
+
+# Prints "<priority> <order> <namespace> <file> <module> <callback>" for
+# every module registered for the given transport. Note that a module is
+# not necessarily in the directory for the transport it is registered for
+describe_modules() {
+	order=0
+
+	for reg in `list_modules register_$1_protocols`; do
+		file=`grep -l "^void $reg(" $srcdir/tcp/*.cc $srcdir/udp/*.cc`
+		if [ -z "$file" ]; then
+			echo "gen_amalgamation.sh: no module defines $reg" >&2
+			exit 1
+		fi
+		base=`basename $file .cc`
+		trans=`basename \`dirname $file\``
+
+		awk -v order=$order -v trans=$trans -v base=$base '
+			/^static lpi_module_t / { body = $0; inmod = 1; next }
+			inmod { body = body " " $0 }
+			inmod && /^};/ { inmod = 0 }
+			END {
+				gsub(/\/\*([^*]|\*+[^*\/])*\*+\//, "", body)
+				gsub(/[ \t]+/, " ", body)
+				split(body, hdr, /[ =]+/)
+				sub(/^[^{]*\{/, "", body)
+				sub(/\}.*$/, "", body)
+				n = split(body, f, ",")
+				for (i = 1; i <= n; i++)
+					gsub(/^ +| +$/, "", f[i])
+				printf "%d %d lpi_amalg_%s_%s %s/%s.cc %s %s\n", \
+					f[4], order, trans, base, trans, base, \
+					hdr[3], f[5]
+			}' $file || exit 1
+
+		order=`expr $order + 1`
+	done
+}
+
+# The preprocessor does the hard work of parsing the arguments here, so
+# all we need to do is find the macro invocations
+emit_corpus() {
+	arg="('([^'\\\\]|\\\\.)+'|[A-Za-z0-9_]+)"
+	sep=" *, *"
+	four="$arg$sep$arg$sep$arg$sep$arg"
+	str='"([^"\\\\]|\\\\.)*"'
+
+	echo "/* Generated by gen_amalgamation.sh from the module sources - do not edit */"
+	echo
+	echo "#define CORPUS_WORD(a, b, c, d) { a, b, c, d },"
+	echo
+	echo "static const int corpus_words[][4] = {"
+	cat $srcdir/tcp/*.cc $srcdir/udp/*.cc | \
+		grep -oE "(MATCH|match_chars_either)\([^,()]+$sep$four|LPI_SIG(_LEN)?\($four" | \
+		sed -E 's/^(MATCH|match_chars_either)\([^,()]+, */CORPUS_WORD(/; s/^LPI_SIG(_LEN)?\(/CORPUS_WORD(/; s/$/)/' | \
+		sort -u
+	echo "};"
+	echo
+	echo "static const char *corpus_strings[] = {"
+	cat $srcdir/tcp/*.cc $srcdir/udp/*.cc | \
+		grep -oE "(MATCHSTR\([^,()]+|match_str_(either|both)\([^,()]+)$sep$str($sep$str)?" | \
+		grep -oE "$str" | sed 's/$/,/' | sort -u
+	echo "};"
+	echo
+	echo "static const uint32_t corpus_lens[] = {"
+	cat $srcdir/tcp/*.cc $srcdir/udp/*.cc | \
+		grep -oE "len(\[[01]\])? *[=<>!]=? *[0-9]+" | \
+		grep -oE "[0-9]+$" | sort -n -u | sed 's/$/,/'
+	echo "};"
+	echo
+	echo "static const uint16_t corpus_ports[] = {"
+	cat $srcdir/tcp/*.cc $srcdir/udp/*.cc | \
+		grep -oE "_port *[=<>!]=? *[0-9]+|_ports\[\] = \{[^}]*\}" | \
+		grep -oE "[0-9]+" | awk '$1 > 0 && $1 < 65536' | \
+		sort -n -u | sed 's/$/,/'
+	echo "};"
+}
+
+if [ "$corpus" = yes ]; then
+	emit_corpus
+	exit 0
+fi
+
+tcp_modules=`describe_modules tcp` || exit 1
+udp_modules=`describe_modules udp` || exit 1
+
+# Modules are tried in priority order, and in the order they were
+# registered within the same priority
+emit_classifier() {
+	echo "static inline lpi_module_t *guess_$1(lpi_data_t *data) {"
+	echo
+	echo "$2" | sort -n -k1,1 -k2,2 | \
+	while read prio order ns file mod callback; do
+		echo "	if (${ns}::${callback}(data, &${ns}::${mod}))"
+		echo "		return &${ns}::${mod};"
+	done
+	echo "	return NULL;"
+	echo "}"
+	echo
+}
+
+emit_includes() {
+	echo "$1" | while read prio order ns file mod callback; do
+		echo "namespace $ns {"
+		echo "#include \"$file\""
+		echo "}"
+	done
+	echo
+}
+
+cat <<EOF
+/* Generated by gen_amalgamation.sh from proto_manager.cc - do not edit */
+
+/* The headers used by the modules must be included here first, so that
+ * their include guards stop them being pulled into each module's
+ * namespace */
+#include <stdio.h>
+#include <string.h>
+
+#include "libprotoident.h"
+#include "proto_manager.h"
+#include "proto_common.h"
+#include "lpi_amalgamated.h"
+
+EOF
+
+emit_includes "$tcp_modules"
+emit_includes "$udp_modules"
+emit_classifier tcp "$tcp_modules"
+emit_classifier udp "$udp_modules"
+
+cat <<EOF
+lpi_module_t *lpi_amalgamated_guess(lpi_data_t *data) {
+
+	lpi_features_t feat;
+	lpi_module_t *p;
+
+	switch(data->trans_proto) {
+		case TRACE_IPPROTO_ICMP:
+			return lpi_icmp;
+		case TRACE_IPPROTO_TCP:
+			begin_guess_features(&feat, data);
+			p = guess_tcp(data);
+			end_guess_features();
+			return (p == NULL) ? lpi_unknown_tcp : p;
+		case TRACE_IPPROTO_UDP:
+			begin_guess_features(&feat, data);
+			p = guess_udp(data);
+			end_guess_features();
+			return (p == NULL) ? lpi_unknown_udp : p;
+	}
+	return lpi_unsupported;
+}
+EOF
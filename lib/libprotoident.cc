@@ -41,21 +41,71 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+#include <strings.h>
+#include <vector>
+#include <algorithm>
 
 #include "libprotoident.h"
 #include "proto_manager.h"
+#include "proto_common.h"
+#include "flow_ext.h"
+#include "decap.h"
 
 
 bool init_called = false;
 LPIModuleMap TCP_protocols;
 LPIModuleMap UDP_protocols;
 
+/* The context used by lpi_guess_protocol() and friends */
+static lpi_context_t default_ctx;
+
 lpi_module_t *lpi_icmp = NULL;
 lpi_module_t *lpi_unsupported = NULL;
 lpi_module_t *lpi_unknown_tcp = NULL;
 lpi_module_t *lpi_unknown_udp = NULL;
 
-static LPINameMap lpi_names;
+/* Protocol names, indexed by protocol. NULL means that there is no active
+ * module for that protocol */
+static const char *lpi_names[LPI_PROTO_LAST];
+
+/* Perfect hash used by lpi_protocol_by_name(). Names are hashed once to
+ * pick a bucket and then again using that bucket's seed to pick a slot.
+ * The seeds are chosen at init time so that no two names share a slot */
+typedef struct lpi_name_hash {
+	uint32_t buckets;
+	uint32_t slots;
+	uint32_t *seeds;
+	uint16_t *table;
+} LPINameHash;
+
+static LPINameHash name_hash;
+
+/* Per-module profiling counters, indexed by protocol */
+typedef struct lpi_profile_counters {
+	uint64_t calls;
+	uint64_t matches;
+	uint64_t ticks;
+} LPIProfileCounters;
+
+static bool profiling = false;
+static LPIProfileCounters profiles[LPI_PROTO_LAST];
+
+/* Protocols and categories that have been disabled for the default 
+ * context */
+static bool protocol_disabled[LPI_PROTO_LAST];
+static uint64_t category_mask = LPI_CATEGORY_MASK_ALL;
+
+/* The number of packets that we'll wait for the first segment in a 
+ * direction to turn up, after seeing a later one */
+#define LPI_REORDER_WINDOW 8
+
+/* Counters for the first segment reordering repairs */
+static uint64_t reorder_held = 0;
+static uint64_t reorder_repaired = 0;
+static uint64_t reorder_committed = 0;
 
 static int seq_cmp (uint32_t seq_a, uint32_t seq_b) {
 
@@ -71,6 +121,184 @@ static int seq_cmp (uint32_t seq_a, uint32_t seq_b) {
 }
 
 
+static void free_context(lpi_context_t *ctx) {
+
+	free_dispatch_table(&ctx->tcp);
+	free_dispatch_table(&ctx->udp);
+}
+
+static int init_context(lpi_context_t *ctx, const bool *enabled) {
+
+	if (build_dispatch_table(&TCP_protocols, &ctx->tcp, enabled) == -1) {
+		free_context(ctx);
+		return -1;
+	}
+	if (build_dispatch_table(&UDP_protocols, &ctx->udp, enabled) == -1) {
+		free_context(ctx);
+		return -1;
+	}
+	return 0;
+}
+
+/* Works out which protocols should be tried by the default context, based
+ * on the protocols and categories that have been disabled */
+static void get_default_enabled(bool *enabled) {
+
+	LPIModuleMap *maps[2] = { &TCP_protocols, &UDP_protocols };
+	LPIModuleMap::iterator it;
+	LPIModuleList::iterator l_it;
+	int i;
+
+	memset(enabled, 0, sizeof(bool) * LPI_PROTO_LAST);
+
+	for (i = 0; i < 2; i++) {
+		for (it = maps[i]->begin(); it != maps[i]->end(); it ++) {
+			LPIModuleList *ml = it->second;
+
+			for (l_it = ml->begin(); l_it != ml->end(); l_it ++) {
+				lpi_module_t *mod = *l_it;
+
+				if (protocol_disabled[mod->protocol])
+					continue;
+				if (!(category_mask & 
+						LPI_CATEGORY_MASK(mod->category)))
+					continue;
+				enabled[mod->protocol] = true;
+			}
+		}
+	}
+}
+
+static int rebuild_default_context(void) {
+
+	bool enabled[LPI_PROTO_LAST];
+
+	get_default_enabled(enabled);
+	if (init_context(&default_ctx, enabled) == -1)
+		return -1;
+
+	/* Anything in the cache may have been matched by a module that has
+	 * just been disabled */
+	clear_result_cache(default_ctx.cache);
+	return 0;
+}
+
+/* Case-insensitive FNV-1a, so that lookups by name match the behaviour of
+ * strcasecmp() */
+static inline uint32_t hash_name(const char *name, uint32_t seed) {
+
+	uint32_t h = 2166136261U ^ seed;
+
+	while (*name) {
+		h ^= (uint8_t)tolower((unsigned char)*name);
+		h *= 16777619U;
+		name ++;
+	}
+	return h ^ (h >> 15);
+}
+
+static void free_name_hash(void) {
+
+	free(name_hash.seeds);
+	free(name_hash.table);
+	memset(&name_hash, 0, sizeof(name_hash));
+}
+
+static uint32_t next_pow2(uint32_t x) {
+
+	uint32_t p = 1;
+
+	while (p < x)
+		p <<= 1;
+	return p;
+}
+
+/* Builds the perfect hash for lpi_protocol_by_name(). Buckets are placed
+ * largest first, trying seeds until every name in the bucket lands in a
+ * free slot */
+static int build_name_hash(void) {
+
+	std::vector<std::vector<uint16_t> > buckets;
+	std::vector<uint32_t> order;
+	uint32_t i, j, n = 0;
+
+	free_name_hash();
+
+	for (i = 0; i < LPI_PROTO_LAST; i++) {
+		if (lpi_names[i] != NULL)
+			n ++;
+	}
+
+	name_hash.buckets = next_pow2(n / 2 + 1);
+	name_hash.slots = next_pow2(n * 2 + 1);
+	name_hash.seeds = (uint32_t *)calloc(name_hash.buckets, 
+			sizeof(uint32_t));
+	name_hash.table = (uint16_t *)malloc(name_hash.slots * 
+			sizeof(uint16_t));
+	if (name_hash.seeds == NULL || name_hash.table == NULL) {
+		fprintf(stderr, "Unable to allocate protocol name hash\n");
+		free_name_hash();
+		return -1;
+	}
+	for (i = 0; i < name_hash.slots; i++)
+		name_hash.table[i] = LPI_PROTO_LAST;
+
+	buckets.resize(name_hash.buckets);
+	for (i = 0; i < LPI_PROTO_LAST; i++) {
+		if (lpi_names[i] == NULL)
+			continue;
+		buckets[hash_name(lpi_names[i], 0) & 
+				(name_hash.buckets - 1)].push_back(i);
+	}
+
+	for (i = 0; i < name_hash.buckets; i++) {
+		if (!buckets[i].empty())
+			order.push_back(i);
+	}
+	for (i = 1; i < order.size(); i++) {
+		uint32_t b = order[i];
+		for (j = i; j > 0 && buckets[order[j - 1]].size() < 
+				buckets[b].size(); j--)
+			order[j] = order[j - 1];
+		order[j] = b;
+	}
+
+	for (i = 0; i < order.size(); i++) {
+		std::vector<uint16_t> &keys = buckets[order[i]];
+		std::vector<uint32_t> placed;
+		uint32_t seed;
+
+		for (seed = 1; seed < 0x100000; seed ++) {
+			placed.clear();
+			for (j = 0; j < keys.size(); j++) {
+				uint32_t slot = hash_name(lpi_names[keys[j]], 
+						seed) & (name_hash.slots - 1);
+
+				if (name_hash.table[slot] != LPI_PROTO_LAST)
+					break;
+				if (std::find(placed.begin(), placed.end(), 
+						slot) != placed.end())
+					break;
+				placed.push_back(slot);
+			}
+			if (j == keys.size())
+				break;
+		}
+
+		if (seed == 0x100000) {
+			fprintf(stderr, "Unable to build protocol name hash\n");
+			free_name_hash();
+			return -1;
+		}
+
+		name_hash.seeds[order[i]] = seed;
+		for (j = 0; j < keys.size(); j++)
+			name_hash.table[placed[j]] = keys[j];
+	}
+
+	return 0;
+}
+
 int lpi_init_library() {
 
 	if (init_called) {
@@ -84,10 +312,17 @@ int lpi_init_library() {
 	if (register_udp_protocols(&UDP_protocols) == -1) 
 		return -1;
 
-	init_other_protocols(&lpi_names);
+	memset(lpi_names, 0, sizeof(lpi_names));
+	init_other_protocols(lpi_names);
+
+	register_names(&TCP_protocols, lpi_names);
+	register_names(&UDP_protocols, lpi_names);
+
+	if (build_name_hash() == -1)
+		return -1;
 
-	register_names(&TCP_protocols, &lpi_names);
-	register_names(&UDP_protocols, &lpi_names);
+	if (rebuild_default_context() == -1)
+		return -1;
 
 	init_called = true;
 
@@ -103,35 +338,64 @@ int lpi_init_library() {
 
 void lpi_free_library() {
 
+	free_context(&default_ctx);
+	free_result_cache(default_ctx.cache);
+	default_ctx.cache = NULL;
+	free_name_hash();
+	free_flow_ext_pool();
+	memset(lpi_names, 0, sizeof(lpi_names));
 	free_protocols(&TCP_protocols);
 	free_protocols(&UDP_protocols);
 
 	init_called = false;
 }
 
+/* Fails to compile if lpi_data_t no longer fits in a cache line */
+typedef char lpi_data_size_check[(sizeof(lpi_data_t) <= 64) ? 1 : -1];
+
 void lpi_init_data(lpi_data_t *data) {
 
 	data->payload[0] = 0;
 	data->payload[1] = 0;
-	data->seen_syn[0] = false;
-	data->seen_syn[1] = false;
-	data->seqno[0] = 0;
-	data->seqno[1] = 0;
+	data->payload_len[0] = 0;
+	data->payload_len[1] = 0;
 	data->observed[0] = 0;
 	data->observed[1] = 0;
+	data->seqno[0] = 0;
+	data->seqno[1] = 0;
+	data->ips[0] = 0;
+	data->ips[1] = 0;
+	data->ip6 = NULL;
+	data->ext_slot = 0;
 	data->server_port = 0;
 	data->client_port = 0;
 	data->trans_proto = 0;
-	data->payload_len[0] = 0;
-	data->payload_len[1] = 0;
-	data->ips[0] = 0;
-	data->ips[1] = 0;
+	data->ip_version = 0;
+	data->seen_syn[0] = false;
+	data->seen_syn[1] = false;
+	data->version = LPI_DATA_VERSION;
+	data->hold_count[0] = 0;
+	data->hold_count[1] = 0;
+
+}
 
+/* Stops waiting for an earlier segment to replace a held payload once 
+ * enough packets have gone by in either direction */
+static inline void advance_hold(lpi_data_t *data, uint8_t dir) {
+
+	if (data->hold_count[dir] == 0)
+		return;
+
+	if (++data->hold_count[dir] > LPI_REORDER_WINDOW) {
+		data->hold_count[dir] = 0;
+		__atomic_add_fetch(&reorder_committed, 1, __ATOMIC_RELAXED);
+	}
 }
 
-static int update_tcp_flow(lpi_data_t *data, libtrace_tcp_t *tcp, uint8_t dir,
-		uint32_t rem, uint32_t psize) {
+static int update_tcp_flow(lpi_data_t *data, const libtrace_tcp_t *tcp, 
+		uint8_t dir, uint32_t rem, uint32_t psize) {
 	uint32_t seq = 0;
+	int cmp;
 
 	if (rem < sizeof(libtrace_tcp_t))
 		return 0;
@@ -145,6 +409,15 @@ static int update_tcp_flow(lpi_data_t *data, libtrace_tcp_t *tcp, uint8_t dir,
 
 	seq = ntohl(tcp->seq);
 
+	advance_hold(data, 0);
+	advance_hold(data, 1);
+
+	/* Once the payload for this direction has been committed, it must
+	 * not change again -- lpi_data_is_complete() has already told the
+	 * caller that it won't */
+	if (data->payload_len[dir] != 0 && data->hold_count[dir] == 0)
+		return 0;
+
 	if (tcp->syn && data->payload_len[dir] == 0) {
 		data->seqno[dir] = seq + 1;
 		data->seen_syn[dir] = true;
@@ -154,20 +427,44 @@ static int update_tcp_flow(lpi_data_t *data, libtrace_tcp_t *tcp, uint8_t dir,
 	 * direction. What do we do?
 	 *
 	 * Current idea: just assume this is the first payload bearing
-	 * packet. Better than running around with an uninitialised seqno */
+	 * packet. Better than running around with an uninitialised seqno.
+	 * Hold it in the same way as a segment that arrived early, though,
+	 * in case an earlier segment is only just behind it */
 	if (data->seen_syn[dir] == false && psize > 0) {
 		data->seqno[dir] = seq;
 		data->seen_syn[dir] = true;
+		data->hold_count[dir] = 1;
+		__atomic_add_fetch(&reorder_held, 1, __ATOMIC_RELAXED);
 	}
 
-	if (seq_cmp(seq, data->seqno[dir]) > 0)
-		return 0;
-	//data->seqno[dir] = seq;
+	cmp = seq_cmp(seq, data->seqno[dir]);
+	if (cmp > 0) {
+		if (psize == 0 || data->payload_len[dir] != 0)
+			return 0;
+
+		/* A later segment has turned up before the one we were
+		 * expecting. Hold on to it in case the expected segment
+		 * never arrives, e.g. because our capture point missed it */
+		data->seqno[dir] = seq;
+		data->hold_count[dir] = 1;
+		__atomic_add_fetch(&reorder_held, 1, __ATOMIC_RELAXED);
+		return 1;
+	}
+
+	if (cmp < 0 && psize > 0 && data->payload_len[dir] != 0) {
+		/* An earlier segment than the one we are holding, so this
+		 * one replaces it. If it leads straight on to the held 
+		 * segment, it is almost certainly the first one */
+		if (seq + psize == data->seqno[dir])
+			data->hold_count[dir] = 0;
+		data->seqno[dir] = seq;
+		__atomic_add_fetch(&reorder_repaired, 1, __ATOMIC_RELAXED);
+	}
 
 	return 1;
 }
 
-static int update_udp_flow(lpi_data_t *data, libtrace_udp_t *udp,
+static int update_udp_flow(lpi_data_t *data, const libtrace_udp_t *udp,
 		uint32_t rem) {
 
 	if (rem < sizeof(libtrace_udp_t))
@@ -181,18 +478,21 @@ static int update_udp_flow(lpi_data_t *data, libtrace_udp_t *udp,
 	return 1;
 }
 
-int lpi_update_data(libtrace_packet_t *packet, lpi_data_t *data, uint8_t dir) {
+/* Does all the work for lpi_update_data_raw() and lpi_update_data_raw6()
+ * except for recording the addresses, which only happens if this returns 1 */
+static int update_data_payload(lpi_data_t *data, uint8_t proto, 
+		const void *l4hdr, uint32_t l4_rem, uint32_t psize, 
+		uint8_t dir) {
 
-	char *payload = NULL;
-	uint32_t psize = 0;
-	uint32_t rem = 0;
-	uint8_t proto = 0;
-	void *transport;
-	uint32_t four_bytes;
-	libtrace_ip_t *ip = NULL;
+	const uint8_t *payload = NULL;
+	uint32_t rem = l4_rem;
+	uint32_t hlen = 0;
+	uint32_t four_bytes = 0;
 
-	//tcp = trace_get_tcp(packet);
-	psize = trace_get_payload_length(packet);
+	/* Packet sizes are recorded for as long as we are asked to, 
+	 * regardless of whether we are still interested in the payload */
+	if (psize > 0)
+		record_packet_size(data, dir, psize);
 
 	/* Don't bother if we've observed 32k of data - the first packet must
 	 * surely been within that. This helps us avoid issues with sequence
@@ -207,35 +507,38 @@ int lpi_update_data(libtrace_packet_t *packet, lpi_data_t *data, uint8_t dir) {
 	if (data->trans_proto != 6 && data->payload_len[dir] != 0)
 		return 0;
 	
-	transport = trace_get_transport(packet, &proto, &rem);
 	if (data->trans_proto == 0)
 		data->trans_proto = proto;
 	
-	if (transport == NULL || rem == 0)
+	if (l4hdr == NULL || rem == 0)
 		return 0;		
 
 	if (proto == 6) {
-		if (update_tcp_flow(data, (libtrace_tcp_t *)transport, dir, rem, psize) == 0) 
-			return 0;
-		payload = (char *)trace_get_payload_from_tcp(
-				(libtrace_tcp_t *)transport, &rem);
-	} 
+		const libtrace_tcp_t *tcp = (const libtrace_tcp_t *)l4hdr;
 
-	if (proto == 17) {
-		if (update_udp_flow(data, (libtrace_udp_t *)transport, rem) == 0)
+		if (update_tcp_flow(data, tcp, dir, rem, psize) == 0) 
 			return 0;
-		payload = (char *)trace_get_payload_from_udp(
-				(libtrace_udp_t *)transport, &rem);
+		hlen = tcp->doff * 4;
+	} else if (proto == 17) {
+		if (update_udp_flow(data, (const libtrace_udp_t *)l4hdr, 
+				rem) == 0)
+			return 0;
+		hlen = sizeof(libtrace_udp_t);
+	} else {
+		return 0;
 	}
 
-	ip = trace_get_ip(packet);
-	
-	if (payload == NULL)
+	if (rem < hlen)
 		return 0;
+	payload = (const uint8_t *)l4hdr + hlen;
+	rem -= hlen;
+
 	if (psize <= 0)
 		return 0;
 
-	four_bytes = (*(uint32_t *)payload);
+	/* Only copy what was actually captured, in case the packet has been
+	 * truncated */
+	memcpy(&four_bytes, payload, rem < 4 ? rem : 4);
 	
 	if (psize < 4) {
 		four_bytes = (ntohl(four_bytes)) >> (8 * (4 - psize));		
@@ -245,70 +548,457 @@ int lpi_update_data(libtrace_packet_t *packet, lpi_data_t *data, uint8_t dir) {
 	data->payload[dir] = four_bytes;
 	data->payload_len[dir] = psize;
 
-	if (ip != NULL && data->ips[0] == 0) {
+	capture_prefix(data, dir, payload, rem < psize ? rem : psize);
+
+	return 1;
+
+}
+
+/* Records the addresses for the flow, if we haven't already */
+static void record_addresses(lpi_data_t *data, uint32_t src_ip, 
+		uint32_t dst_ip, uint8_t dir) {
+
+	if ((src_ip != 0 || dst_ip != 0) && data->ips[0] == 0) {
 		if (dir == 0) {
-			data->ips[0] = ip->ip_src.s_addr;
-			data->ips[1] = ip->ip_dst.s_addr;
+			data->ips[0] = src_ip;
+			data->ips[1] = dst_ip;
 		} else {
-			data->ips[1] = ip->ip_src.s_addr;
-			data->ips[0] = ip->ip_dst.s_addr;
+			data->ips[1] = src_ip;
+			data->ips[0] = dst_ip;
 		}
+		data->ip_version = 4;
 	}
+}
+
+static void record_addresses6(lpi_data_t *data, const uint8_t *src_ip6,
+		const uint8_t *dst_ip6, uint8_t dir) {
 
+	const uint8_t *local, *remote;
+
+	if (src_ip6 == NULL || dst_ip6 == NULL || data->ip_version != 0)
+		return;
+
+	if (dir == 0) {
+		local = src_ip6;
+		remote = dst_ip6;
+	} else {
+		local = dst_ip6;
+		remote = src_ip6;
+	}
+
+	/* Keep the last four bytes in ips, so that the rules that look for 
+	 * an address in the payload work the same way for both families */
+	memcpy(&data->ips[0], local + 12, sizeof(uint32_t));
+	memcpy(&data->ips[1], remote + 12, sizeof(uint32_t));
+	data->ip_version = 6;
+
+	if (data->ip6 != NULL) {
+		memcpy(data->ip6->addr[0], local, 16);
+		memcpy(data->ip6->addr[1], remote, 16);
+	}
+}
+
+int lpi_update_data_raw(lpi_data_t *data, uint8_t proto, const void *l4hdr,
+		uint32_t l4_rem, uint32_t psize, uint32_t src_ip, 
+		uint32_t dst_ip, uint8_t dir) {
+
+	if (update_data_payload(data, proto, l4hdr, l4_rem, psize, dir) == 0)
+		return 0;
+
+	record_addresses(data, src_ip, dst_ip, dir);
 	return 1;
+}
+
+int lpi_update_data_raw6(lpi_data_t *data, uint8_t proto, const void *l4hdr,
+		uint32_t l4_rem, uint32_t psize, const uint8_t *src_ip6,
+		const uint8_t *dst_ip6, uint8_t dir) {
+
+	if (update_data_payload(data, proto, l4hdr, l4_rem, psize, dir) == 0)
+		return 0;
 
+	record_addresses6(data, src_ip6, dst_ip6, dir);
+	return 1;
 }
 
-static lpi_module_t *test_protocol_list(LPIModuleList *ml, lpi_data_t *data) {
+/* Returns true if a packet found inside a tunnel belongs to the same inner
+ * flow as the packets that the LPI data has already seen.
+ *
+ * The caller keys the flow on the outer headers, so every packet in the
+ * tunnel is passed in with the same LPI data even if the tunnel is 
+ * carrying several unrelated flows. Mixing them up would leave the LPI 
+ * data with the ports of one flow and the payload of another, so we only
+ * follow the first inner flow and ignore the rest. The protocol, ports and
+ * addresses of that flow are all recorded by its first packet.
+ */
+static bool same_inner_flow(lpi_data_t *data, const lpi_inner_t *inner) {
+
+	uint16_t ports[2];
+	uint32_t addrs[2];
+
+	if (data->trans_proto == 0)
+		return true;
+	if (inner->proto != data->trans_proto)
+		return false;
+
+	if (data->server_port != 0 || data->client_port != 0) {
+		if (inner->l4 == NULL || inner->l4_rem < sizeof(ports))
+			return false;
+		memcpy(ports, inner->l4, sizeof(ports));
+		ports[0] = ntohs(ports[0]);
+		ports[1] = ntohs(ports[1]);
+
+		if (!(ports[0] == data->client_port && 
+				ports[1] == data->server_port) &&
+				!(ports[0] == data->server_port &&
+				ports[1] == data->client_port))
+			return false;
+	}
+
+	if (data->ip_version == 0)
+		return true;
+
+	/* Only the last four bytes of an IPv6 address are kept, but that 
+	 * will do for telling flows in the same tunnel apart */
+	if (inner->ethertype == TRACE_ETHERTYPE_IPV6) {
+		if (data->ip_version != 6)
+			return false;
+		memcpy(addrs, inner->l3 + 20, sizeof(uint32_t));
+		memcpy(addrs + 1, inner->l3 + 36, sizeof(uint32_t));
+	} else {
+		if (data->ip_version != 4)
+			return false;
+		memcpy(addrs, inner->l3 + 12, sizeof(uint32_t));
+		memcpy(addrs + 1, inner->l3 + 16, sizeof(uint32_t));
+	}
+
+	if (addrs[0] == data->ips[0] && addrs[1] == data->ips[1])
+		return true;
+	if (addrs[0] == data->ips[1] && addrs[1] == data->ips[0])
+		return true;
+	return false;
+}
+
+/* Updates the LPI data using a packet found inside a tunnel */
+static int update_data_inner(lpi_data_t *data, const lpi_inner_t *inner,
+		uint8_t dir) {
+
+	uint32_t src_ip, dst_ip;
+	int ret;
+
+	if (!same_inner_flow(data, inner))
+		return 0;
+
+	ret = update_data_payload(data, inner->proto, inner->l4, 
+			inner->l4_rem, inner->payload_len, dir);
+
+	/* Unlike an ordinary flow, the addresses are recorded even if the
+	 * packet carries no payload, so that the inner flow is pinned down
+	 * by its first packet */
+	if (inner->ethertype == TRACE_ETHERTYPE_IPV6) {
+		record_addresses6(data, inner->l3 + 8, inner->l3 + 24, dir);
+	} else {
+		memcpy(&src_ip, inner->l3 + 12, sizeof(uint32_t));
+		memcpy(&dst_ip, inner->l3 + 16, sizeof(uint32_t));
+		record_addresses(data, src_ip, dst_ip, dir);
+	}
+
+	return ret;
+}
+
+int lpi_update_data(libtrace_packet_t *packet, lpi_data_t *data, uint8_t dir) {
+
+	void *transport = NULL;
+	uint32_t psize = 0;
+	uint32_t rem = 0;
+	uint8_t proto = 0;
+	libtrace_ip_t *ip = NULL;
+	libtrace_ip6_t *ip6 = NULL;
+	uint32_t src_ip = 0, dst_ip = 0;
+	lpi_inner_t inner;
+
+	/* If the packet is tunnelled, we want to look at what is inside */
+	if (decap_enabled() && lpi_decapsulate(packet, &inner) > 0)
+		return update_data_inner(data, &inner, dir);
+
+	psize = trace_get_payload_length(packet);
+
+	/* Don't parse the rest of the packet if lpi_update_data_raw() is 
+	 * only going to count the payload and ignore it */
+	if (data->observed[dir] <= 32 * 1024 && (data->trans_proto == 6 || 
+			data->payload_len[dir] == 0)) {
+		transport = trace_get_transport(packet, &proto, &rem);
+		ip = trace_get_ip(packet);
+		if (ip != NULL) {
+			src_ip = ip->ip_src.s_addr;
+			dst_ip = ip->ip_dst.s_addr;
+		} else if ((ip6 = trace_get_ip6(packet)) != NULL) {
+			return lpi_update_data_raw6(data, proto, transport, 
+					rem, psize, 
+					(const uint8_t *)&ip6->ip_src, 
+					(const uint8_t *)&ip6->ip_dst, dir);
+		}
+	}
+
+	return lpi_update_data_raw(data, proto, transport, rem, psize, 
+			src_ip, dst_ip, dir);
+}
+
+/* A direction is settled once we have its first payload (and are no 
+ * longer waiting to see whether an earlier segment turns up), or once 
+ * lpi_update_data() has given up on it */
+static inline bool direction_settled(lpi_data_t *data, uint8_t dir) {
+
+	if (data->payload_len[dir] != 0 && data->hold_count[dir] == 0)
+		return true;
+	if (data->observed[dir] > 32 * 1024)
+		return true;
+	return false;
+}
+
+/* Returns true if no further packets can change the payload, lengths or
+ * ports that the rules look at */
+static inline bool payload_complete(lpi_data_t *data) {
+
+	switch(data->trans_proto) {
+		case TRACE_IPPROTO_TCP:
+		case TRACE_IPPROTO_UDP:
+			return direction_settled(data, 0) && 
+					direction_settled(data, 1);
+		case 0:
+			/* Haven't seen a packet for this flow yet */
+			return false;
+	}
+
+	/* We only look at the transport protocol for anything else */
+	return true;
+}
+
+bool lpi_data_is_complete(lpi_data_t *data) {
+
+	if (!payload_complete(data))
+		return false;
+	return size_sequence_full(data->ext_slot);
+}
+
+void lpi_get_reorder_stats(lpi_reorder_stats_t *stats) {
+
+	stats->held = __atomic_load_n(&reorder_held, __ATOMIC_RELAXED);
+	stats->repaired = __atomic_load_n(&reorder_repaired, __ATOMIC_RELAXED);
+	stats->committed = __atomic_load_n(&reorder_committed, 
+			__ATOMIC_RELAXED);
+}
+
+static inline bool match_signature_dir(const lpi_signature_t *sig,
+		uint32_t payload, uint32_t len) {
+
+	if ((payload & sig->mask) != sig->value)
+		return false;
+	if (len < sig->min_len)
+		return false;
+	if (sig->max_len != 0 && len > sig->max_len)
+		return false;
+	return true;
+}
+
+/* Returns true if either payload matches one of the signatures */
+static inline bool match_signatures(const lpi_signature_t *sig, 
+		lpi_data_t *data) {
+
+	for (; sig->mask != 0; sig++) {
+		if (match_signature_dir(sig, data->payload[0], 
+				data->payload_len[0]))
+			return true;
+		if (match_signature_dir(sig, data->payload[1], 
+				data->payload_len[1]))
+			return true;
+	}
+	return false;
+}
+
+/* Tests the signatures of a module that didn't get a bit in the signature
+ * scan, one at a time */
+static inline bool match_unscanned(LPIDispatchEntry *entry, 
+		lpi_data_t *data) {
+
+	if (entry->sig_bit != LPI_SIG_UNSCANNED)
+		return false;
+	return match_signatures(entry->module->signatures, data);
+}
+
+/* Returns the current time for profiling purposes: the TSC on x86, 
+ * nanoseconds elsewhere */
+static inline uint64_t profile_clock(void) {
+#if defined(__i386__) || defined(__x86_64__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+/* Runs a module callback, updating the profiling counters for the module.
+ * Workers in a pool may be doing this at the same time, hence the atomic
+ * updates */
+static bool run_callback_profiled(LPIDispatchEntry *entry, 
+		lpi_data_t *data) {
+
+	LPIProfileCounters *prof = &profiles[entry->module->protocol];
+	uint64_t start, end;
+	bool result;
+
+	start = profile_clock();
+	result = entry->lpi_callback(data, entry->module);
+	end = profile_clock();
+
+	__atomic_add_fetch(&prof->calls, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&prof->ticks, end - start, __ATOMIC_RELAXED);
+	if (result)
+		__atomic_add_fetch(&prof->matches, 1, __ATOMIC_RELAXED);
+	return result;
+}
+
+/* This is always inlined into the two functions below, so the check on
+ * 'profile' is resolved at compile time and costs nothing when profiling
+ * is disabled */
+static inline __attribute__((always_inline)) lpi_module_t *
+		guess_protocol_common(LPIDispatchTable *table, 
+		lpi_data_t *data, const bool profile) {
+
+	const uint64_t *srv, *cli, *pre0, *pre1;
+	const uint64_t *len0 = NULL, *len1 = NULL;
+	uint64_t sig_hits = 0;
+	bool scanned = false;
+	uint32_t w;
+
+	if (table->count == 0)
+		return NULL;
 
-	LPIModuleList::iterator l_it;
-	
 	/* Turns out naively looping through the modules is quicker
 	 * than trying to do intelligent stuff with threads. Most
 	 * callbacks complete very quickly so threading overhead is a
-	 * major problem */
-	for (l_it = ml->begin(); l_it != ml->end(); l_it ++) {
-		lpi_module_t *module = *l_it;
+	 * major problem.
+	 *
+	 * We can still avoid calling modules that cannot possibly match,
+	 * though. Modules that require particular ports are only tried if
+	 * the flow is using one of those ports -- the candidate set is
+	 * built by OR-ing the bitsets for both ports with the set of
+	 * modules that are always tried.
+	 *
+	 * The table is already sorted by priority, so walking the
+	 * candidate bits from lowest to highest and returning the first
+	 * module that matches gives the same answer as trying every
+	 * module in turn.
+	 *
+	 * Likewise, modules that have declared payload signatures are only
+	 * tried if the first byte of payload in either direction could
+	 * match one of those signatures. The remaining bytes and the 
+	 * length bounds are checked when we reach the first such module,
+	 * by testing the flow against every signature at once.
+	 *
+	 * Modules that have declared the payload lengths they can match are
+	 * only tried if one payload length is accepted by their first list 
+	 * and the other by their second.
+	 */
+	srv = table->port_sets + 
+			table->port_index[data->server_port] * table->words;
+	cli = table->port_sets + 
+			table->port_index[data->client_port] * table->words;
+	pre0 = table->prefix_sets + 
+			((uint8_t *)&data->payload[0])[0] * table->words;
+	pre1 = table->prefix_sets + 
+			((uint8_t *)&data->payload[1])[0] * table->words;
+	if (table->len_sets != NULL) {
+		len0 = table->len_sets + 2 * table->words * table->len_index[
+				length_bucket(data->payload_len[0])];
+		len1 = table->len_sets + 2 * table->words * table->len_index[
+				length_bucket(data->payload_len[1])];
+	}
+
+	for (w = 0; w < table->words; w++) {
+		uint64_t cand = (table->port_free[w] | srv[w] | cli[w]) &
+				(table->sig_free[w] | pre0[w] | pre1[w]);
 
-		/* To save time, I'm going to break on the first successful
-		 * match. A threaded version would wait for all the modules
-		 * to run, storing all successful results in a list of some
-		 * sort and selecting an appropriate result from there.
-		 */
+		if (len0 != NULL) {
+			cand &= table->len_free[w] | 
+					(len0[w] & len1[table->words + w]) |
+					(len1[w] & len0[table->words + w]);
+		}
 
-		if (module->lpi_callback(data, module)) 
-			return module;
-		
+		while (cand != 0) {
+			LPIDispatchEntry *entry = table->entries + (w * 64) + 
+					__builtin_ctzll(cand);
+
+			cand &= (cand - 1);
+			if (entry->sig_bit != 0) {
+				if (!scanned) {
+					sig_hits = scan_signatures(&table->sigs,
+						data->payload[0], 
+						data->payload_len[0],
+						data->payload[1], 
+						data->payload_len[1]);
+					scanned = true;
+				}
+				if ((sig_hits & entry->sig_bit) == 0 &&
+						!match_unscanned(entry, data))
+					continue;
+			}
+			if (profile) {
+				if (run_callback_profiled(entry, data))
+					return entry->module;
+			} else if (entry->lpi_callback(data, entry->module))
+				return entry->module;
+		}
 	}
 
 	return NULL;
+
+}
+
+static lpi_module_t *guess_protocol(LPIDispatchTable *table, 
+		lpi_data_t *data) {
+
+	return guess_protocol_common(table, data, false);
 }
-static lpi_module_t *guess_protocol(LPIModuleMap *modmap, lpi_data_t *data) {
 
-	lpi_module_t *proto = NULL;
+static lpi_module_t *guess_protocol_profiled(LPIDispatchTable *table, 
+		lpi_data_t *data) {
 
-	LPIModuleMap::iterator m_it;
+	return guess_protocol_common(table, data, true);
+}
 
-	/* Deal with each priority in turn - want to match higher priority
-	 * rules first. 
-	 */
+/* Same as guess_protocol(), but checks the context's result cache first and
+ * adds the result to the cache if it wasn't there */
+static lpi_module_t *guess_protocol_cached(lpi_context_t *ctx, 
+		LPIDispatchTable *table, lpi_data_t *data, 
+		lpi_module_t *unknown) {
 
-	for (m_it = modmap->begin(); m_it != modmap->end(); m_it ++) {
-		LPIModuleList *ml = m_it->second;
-		
-		proto = test_protocol_list(ml, data);
+	LPICacheKey key;
+	lpi_module_t *p;
 
-		if (proto != NULL)
-			break;
+	if (!make_cache_key(data, &key)) {
+		count_cache_bypass(ctx->cache);
+		p = guess_protocol(table, data);
+		return (p == NULL) ? unknown : p;
 	}
 
-	return proto;
+	p = lookup_result_cache(ctx->cache, &key);
+	if (p != NULL)
+		return p;
 
+	p = guess_protocol(table, data);
+	if (p == NULL)
+		p = unknown;
+	insert_result_cache(ctx->cache, &key, p);
+	return p;
 }
 
-lpi_module_t *lpi_guess_protocol(lpi_data_t *data) {
+lpi_module_t *lpi_ctx_guess(lpi_context_t *ctx, lpi_data_t *data) {
 
+	LPIDispatchTable *table;
 	lpi_module_t *p = NULL;
+	lpi_module_t *unknown;
 
 	if (!init_called) {
 		fprintf(stderr, "lpi_init_library was never called - cannot guess the protocol\n");
@@ -319,24 +1009,526 @@ lpi_module_t *lpi_guess_protocol(lpi_data_t *data) {
 		case TRACE_IPPROTO_ICMP:
 			return lpi_icmp;
 		case TRACE_IPPROTO_TCP:
-			p = guess_protocol(&TCP_protocols, data);
-			if (p == NULL)
-				p = lpi_unknown_tcp;
-			return p;
-
+			table = &ctx->tcp;
+			unknown = lpi_unknown_tcp;
+			break;
 		case TRACE_IPPROTO_UDP:
-			p = guess_protocol(&UDP_protocols, data);
-			if (p == NULL)
-				p = lpi_unknown_udp;
-			return p;
+			table = &ctx->udp;
+			unknown = lpi_unknown_udp;
+			break;
 		default:
 			return lpi_unsupported;
 	}
 
+	/* Cached results would hide the work done by each module from the
+	 * profiler, so don't use the cache while profiling */
+	if (profiling)
+		p = guess_protocol_profiled(table, data);
+	else if (ctx->cache != NULL)
+		return guess_protocol_cached(ctx, table, data, unknown);
+	else
+		p = guess_protocol(table, data);
+
+	if (p == NULL)
+		p = unknown;
+	return p;
+}
+
+lpi_module_t *lpi_guess_protocol(lpi_data_t *data) {
+
+	return lpi_ctx_guess(&default_ctx, data);
+}
+
+lpi_module_t *lpi_ctx_guess_ex(lpi_context_t *ctx, lpi_data_t *data, 
+		bool *final) {
+
+	lpi_module_t *p = lpi_ctx_guess(ctx, data);
 
+	*final = (p != NULL) && payload_complete(data);
 	return p;
 }
+
+lpi_module_t *lpi_guess_protocol_ex(lpi_data_t *data, bool *final) {
+
+	return lpi_ctx_guess_ex(&default_ctx, data, final);
+}
 	
+/* Flows are classified in chunks of this many at a time, so that the
+ * structure-of-arrays copy of each chunk fits comfortably on the stack
+ * and in the L1 cache */
+#define LPI_BATCH_CHUNK 256
+
+/* Structure-of-arrays copy of the fields of each flow in a chunk that the
+ * library itself needs to look at. Flows that have not been matched yet
+ * are kept packed at the start of each array */
+typedef struct lpi_batch_chunk {
+	uint32_t pending;
+	uint32_t index[LPI_BATCH_CHUNK];	/* Position in the caller's array */
+	uint32_t payload0[LPI_BATCH_CHUNK];
+	uint32_t payload1[LPI_BATCH_CHUNK];
+	uint32_t len0[LPI_BATCH_CHUNK];
+	uint32_t len1[LPI_BATCH_CHUNK];
+	uint16_t server_set[LPI_BATCH_CHUNK];	/* port_index[server_port] */
+	uint16_t client_set[LPI_BATCH_CHUNK];	/* port_index[client_port] */
+	uint8_t prefix0[LPI_BATCH_CHUNK];	/* First byte of payload0 */
+	uint8_t prefix1[LPI_BATCH_CHUNK];	/* First byte of payload1 */
+	uint16_t len_set0[LPI_BATCH_CHUNK];	/* len_index for len0 */
+	uint16_t len_set1[LPI_BATCH_CHUNK];	/* len_index for len1 */
+
+	/* The result of scan_signatures() for each flow, which is only 
+	 * filled in once a module with signatures is reached */
+	uint64_t sig_hits[LPI_BATCH_CHUNK];
+	bool sig_scanned;
+
+	/* The candidate bits for the 64 modules currently being tried, for 
+	 * each flow and for the chunk as a whole */
+	uint64_t cand[LPI_BATCH_CHUNK];
+	uint64_t any_cand;
+
+	/* The features each flow has been found to have so far */
+	lpi_features_t features[LPI_BATCH_CHUNK];
+} LPIBatchChunk;
+
+static void add_to_chunk(LPIDispatchTable *table, LPIBatchChunk *chunk,
+		lpi_data_t *data, uint32_t index) {
+
+	uint32_t j = chunk->pending;
+
+	chunk->index[j] = index;
+	chunk->payload0[j] = data->payload[0];
+	chunk->payload1[j] = data->payload[1];
+	chunk->len0[j] = data->payload_len[0];
+	chunk->len1[j] = data->payload_len[1];
+	chunk->server_set[j] = table->port_index[data->server_port];
+	chunk->client_set[j] = table->port_index[data->client_port];
+	chunk->prefix0[j] = ((uint8_t *)&data->payload[0])[0];
+	chunk->prefix1[j] = ((uint8_t *)&data->payload[1])[0];
+	if (table->len_sets != NULL) {
+		chunk->len_set0[j] = table->len_index[
+				length_bucket(data->payload_len[0])];
+		chunk->len_set1[j] = table->len_index[
+				length_bucket(data->payload_len[1])];
+	}
+	chunk->features[j].data = data;
+	chunk->features[j].known = 0;
+	chunk->features[j].present = 0;
+	chunk->pending ++;
+}
+
+/* Removes a flow from the chunk, once it has been matched */
+static inline void remove_from_chunk(LPIBatchChunk *chunk, uint32_t j) {
+
+	uint32_t last = chunk->pending - 1;
+
+	chunk->index[j] = chunk->index[last];
+	chunk->payload0[j] = chunk->payload0[last];
+	chunk->payload1[j] = chunk->payload1[last];
+	chunk->len0[j] = chunk->len0[last];
+	chunk->len1[j] = chunk->len1[last];
+	chunk->server_set[j] = chunk->server_set[last];
+	chunk->client_set[j] = chunk->client_set[last];
+	chunk->prefix0[j] = chunk->prefix0[last];
+	chunk->prefix1[j] = chunk->prefix1[last];
+	chunk->len_set0[j] = chunk->len_set0[last];
+	chunk->len_set1[j] = chunk->len_set1[last];
+	chunk->sig_hits[j] = chunk->sig_hits[last];
+	chunk->cand[j] = chunk->cand[last];
+	chunk->features[j] = chunk->features[last];
+	chunk->pending = last;
+}
+
+/* Works out the candidate bits for word 'w' of the dispatch table for 
+ * every pending flow, using the same port, prefix and length tests as 
+ * guess_protocol().
+ *
+ * This loop only touches the arrays in the chunk and has no branches that
+ * depend on the flow, so the compiler is free to vectorise it.
+ */
+static void select_candidates(LPIDispatchTable *table, LPIBatchChunk *chunk,
+		uint32_t w) {
+
+	uint32_t j, n = chunk->pending;
+	const uint64_t *ports = table->port_sets + w;
+	const uint64_t *prefixes = table->prefix_sets + w;
+	uint64_t port_free = table->port_free[w];
+	uint64_t sig_free = table->sig_free[w];
+	uint64_t any = 0;
+
+	for (j = 0; j < n; j++) {
+		chunk->cand[j] = (port_free | 
+				ports[chunk->server_set[j] * table->words] |
+				ports[chunk->client_set[j] * table->words]) &
+			(sig_free | 
+				prefixes[chunk->prefix0[j] * table->words] |
+				prefixes[chunk->prefix1[j] * table->words]);
+	}
+
+	if (table->len_sets != NULL) {
+		const uint64_t *lens = table->len_sets + w;
+		uint32_t stride = 2 * table->words;
+		uint64_t len_free = table->len_free[w];
+
+		for (j = 0; j < n; j++) {
+			const uint64_t *len0 = lens + chunk->len_set0[j] * stride;
+			const uint64_t *len1 = lens + chunk->len_set1[j] * stride;
+
+			chunk->cand[j] &= len_free | 
+					(len0[0] & len1[table->words]) |
+					(len1[0] & len0[table->words]);
+		}
+	}
+
+	for (j = 0; j < n; j++)
+		any |= chunk->cand[j];
+	chunk->any_cand = any;
+}
+
+/* Scans the signatures for every pending flow */
+static void scan_signatures_chunk(LPIDispatchTable *table, 
+		LPIBatchChunk *chunk) {
+
+	uint32_t j;
+
+	for (j = 0; j < chunk->pending; j++) {
+		chunk->sig_hits[j] = scan_signatures(&table->sigs, 
+				chunk->payload0[j], chunk->len0[j],
+				chunk->payload1[j], chunk->len1[j]);
+	}
+	chunk->sig_scanned = true;
+}
+
+/* Same as match_unscanned(), for a pending flow */
+static inline bool match_unscanned_chunk(LPIDispatchEntry *entry, 
+		LPIBatchChunk *chunk, uint32_t j) {
+
+	const lpi_signature_t *sig = entry->module->signatures;
+
+	if (entry->sig_bit != LPI_SIG_UNSCANNED)
+		return false;
+
+	for (; sig->mask != 0; sig++) {
+		if (match_signature_dir(sig, chunk->payload0[j], 
+				chunk->len0[j]))
+			return true;
+		if (match_signature_dir(sig, chunk->payload1[j], 
+				chunk->len1[j]))
+			return true;
+	}
+	return false;
+}
+
+/* Looks up a flow from a batch in the context's result cache. Returns true
+ * if the result was found, otherwise the flow needs to be classified
+ * normally */
+static inline bool cached_batch_result(lpi_context_t *ctx, lpi_data_t *data,
+		lpi_module_t **out) {
+
+	LPICacheKey key;
+
+	if (ctx->cache == NULL)
+		return false;
+	if (!make_cache_key(data, &key)) {
+		count_cache_bypass(ctx->cache);
+		return false;
+	}
+
+	*out = lookup_result_cache(ctx->cache, &key);
+	return (*out != NULL);
+}
+
+/* Adds the result for a flow from a batch to the result cache */
+static inline void cache_batch_result(LPIResultCache *cache, 
+		lpi_data_t *data, lpi_module_t *module) {
+
+	LPICacheKey key;
+
+	if (cache != NULL && make_cache_key(data, &key))
+		insert_result_cache(cache, &key, module);
+}
+
+/* Classifies every flow in the chunk, one module at a time. Because the 
+ * modules are walked in priority order and flows are removed from the 
+ * chunk as soon as they match, every flow ends up with the same module that
+ * guess_protocol() would have given it */
+static void guess_protocol_chunk(LPIDispatchTable *table, 
+		LPIBatchChunk *chunk, lpi_data_t **flows, lpi_module_t **out,
+		lpi_module_t *unknown, LPIResultCache *cache) {
+
+	/* Only look up the thread's feature pointer once per chunk, rather 
+	 * than once per callback */
+	lpi_features_t **guess_features = &lpi_guess_features;
+	uint32_t i, j;
+
+	use_guess_features();
+	chunk->sig_scanned = false;
+
+	for (i = 0; i < table->count && chunk->pending > 0; i++) {
+		LPIDispatchEntry *entry = &table->entries[i];
+		uint64_t bit = ((uint64_t)1 << (i % 64));
+
+		if (i % 64 == 0)
+			select_candidates(table, chunk, i / 64);
+
+		/* No flow in the chunk can possibly match this module */
+		if ((chunk->any_cand & bit) == 0)
+			continue;
+
+		if (entry->sig_bit != 0 && !chunk->sig_scanned)
+			scan_signatures_chunk(table, chunk);
+
+		j = 0;
+		while (j < chunk->pending) {
+			uint32_t idx = chunk->index[j];
+
+			if ((chunk->cand[j] & bit) == 0 || 
+					(entry->sig_bit != 0 && 
+					(chunk->sig_hits[j] & 
+					entry->sig_bit) == 0 &&
+					!match_unscanned_chunk(entry, 
+					chunk, j))) {
+				j ++;
+				continue;
+			}
+
+			*guess_features = &chunk->features[j];
+			if (entry->lpi_callback(flows[idx], entry->module)) {
+				out[idx] = entry->module;
+				cache_batch_result(cache, flows[idx], 
+						entry->module);
+				remove_from_chunk(chunk, j);
+				continue;
+			}
+			j ++;
+		}
+	}
+
+	*guess_features = NULL;
+
+	for (j = 0; j < chunk->pending; j++) {
+		out[chunk->index[j]] = unknown;
+		cache_batch_result(cache, flows[chunk->index[j]], unknown);
+	}
+	chunk->pending = 0;
+}
+
+int lpi_ctx_guess_batch(lpi_context_t *ctx, lpi_data_t **flows, size_t n,
+		lpi_module_t **out) {
+
+	LPIBatchChunk tcp, udp;
+	size_t i;
+
+	if (!init_called) {
+		fprintf(stderr, "lpi_init_library was never called - cannot guess the protocol\n");
+		return -1;
+	}
+
+	/* The batch code doesn't keep track of per-module costs, so fall
+	 * back to classifying the flows one at a time while profiling */
+	if (profiling) {
+		for (i = 0; i < n; i++)
+			out[i] = lpi_ctx_guess(ctx, flows[i]);
+		return 0;
+	}
+
+	tcp.pending = 0;
+	udp.pending = 0;
+
+	for (i = 0; i < n; i++) {
+		lpi_data_t *data = flows[i];
+
+		switch(data->trans_proto) {
+			case TRACE_IPPROTO_ICMP:
+				out[i] = lpi_icmp;
+				break;
+			case TRACE_IPPROTO_TCP:
+				if (ctx->tcp.count == 0) {
+					out[i] = lpi_unknown_tcp;
+					break;
+				}
+				if (cached_batch_result(ctx, data, &out[i]))
+					break;
+				add_to_chunk(&ctx->tcp, &tcp, data, i);
+				if (tcp.pending == LPI_BATCH_CHUNK)
+					guess_protocol_chunk(&ctx->tcp,
+						&tcp, flows, out, 
+						lpi_unknown_tcp, ctx->cache);
+				break;
+			case TRACE_IPPROTO_UDP:
+				if (ctx->udp.count == 0) {
+					out[i] = lpi_unknown_udp;
+					break;
+				}
+				if (cached_batch_result(ctx, data, &out[i]))
+					break;
+				add_to_chunk(&ctx->udp, &udp, data, i);
+				if (udp.pending == LPI_BATCH_CHUNK)
+					guess_protocol_chunk(&ctx->udp,
+						&udp, flows, out, 
+						lpi_unknown_udp, ctx->cache);
+				break;
+			default:
+				out[i] = lpi_unsupported;
+				break;
+		}
+	}
+
+	if (tcp.pending > 0)
+		guess_protocol_chunk(&ctx->tcp, &tcp, flows, out, 
+				lpi_unknown_tcp, ctx->cache);
+	if (udp.pending > 0)
+		guess_protocol_chunk(&ctx->udp, &udp, flows, out, 
+				lpi_unknown_udp, ctx->cache);
+	return 0;
+}
+
+int lpi_guess_protocol_batch(lpi_data_t **flows, size_t n, 
+		lpi_module_t **out) {
+
+	return lpi_ctx_guess_batch(&default_ctx, flows, n, out);
+}
+
+lpi_context_t *lpi_ctx_create(const bool *enabled) {
+
+	lpi_context_t *ctx;
+
+	if (!init_called) {
+		fprintf(stderr, "lpi_init_library was never called - cannot create a context\n");
+		return NULL;
+	}
+
+	ctx = (lpi_context_t *)calloc(1, sizeof(lpi_context_t));
+	if (ctx == NULL) {
+		fprintf(stderr, "Unable to allocate memory for LPI context\n");
+		return NULL;
+	}
+
+	if (init_context(ctx, enabled) == -1) {
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+void lpi_ctx_destroy(lpi_context_t *ctx) {
+
+	if (ctx == NULL)
+		return;
+	free_context(ctx);
+	free_result_cache(ctx->cache);
+	free(ctx);
+}
+
+int lpi_ctx_set_cache_size(lpi_context_t *ctx, uint32_t entries) {
+
+	LPIResultCache *cache = NULL;
+
+	if (entries != 0) {
+		cache = create_result_cache(entries);
+		if (cache == NULL)
+			return -1;
+	}
+
+	free_result_cache(ctx->cache);
+	ctx->cache = cache;
+	return 0;
+}
+
+int lpi_set_cache_size(uint32_t entries) {
+
+	return lpi_ctx_set_cache_size(&default_ctx, entries);
+}
+
+void lpi_ctx_get_cache_stats(lpi_context_t *ctx, lpi_cache_stats_t *stats) {
+
+	get_result_cache_stats(ctx->cache, stats);
+}
+
+void lpi_get_cache_stats(lpi_cache_stats_t *stats) {
+
+	lpi_ctx_get_cache_stats(&default_ctx, stats);
+}
+
+int lpi_set_protocol_enabled(lpi_protocol_t proto, bool enabled) {
+
+	if (proto < 0 || proto >= LPI_PROTO_LAST)
+		return -1;
+
+	if (protocol_disabled[proto] == !enabled)
+		return 0;
+	protocol_disabled[proto] = !enabled;
+
+	/* If the library hasn't been initialised yet, the change will be
+	 * picked up when the dispatch tables are first built */
+	if (!init_called)
+		return 0;
+	return rebuild_default_context();
+}
+
+int lpi_set_category_mask(uint64_t mask) {
+
+	if (category_mask == mask)
+		return 0;
+	category_mask = mask;
+
+	if (!init_called)
+		return 0;
+	return rebuild_default_context();
+}
+
+lpi_category_t lpi_categorise_protocol(lpi_protocol_t proto) {
+
+	LPIModuleMap *maps[2] = { &TCP_protocols, &UDP_protocols };
+	lpi_module_t *others[4] = { lpi_icmp, lpi_unknown_tcp, 
+			lpi_unknown_udp, lpi_unsupported };
+	LPIModuleMap::iterator it;
+	LPIModuleList::iterator l_it;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		for (it = maps[i]->begin(); it != maps[i]->end(); it ++) {
+			LPIModuleList *ml = it->second;
+
+			for (l_it = ml->begin(); l_it != ml->end(); l_it ++) {
+				if ((*l_it)->protocol == proto)
+					return (*l_it)->category;
+			}
+		}
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (others[i] && others[i]->protocol == proto)
+			return others[i]->category;
+	}
+
+	return LPI_CATEGORY_NO_CATEGORY;
+}
+
+void lpi_set_profiling(bool enabled) {
+
+	profiling = enabled;
+}
+
+void lpi_reset_module_profiles(void) {
+
+	memset(profiles, 0, sizeof(profiles));
+}
+
+int lpi_get_module_profile(lpi_protocol_t proto, 
+		lpi_module_profile_t *profile) {
+
+	if (proto < 0 || proto >= LPI_PROTO_LAST)
+		return -1;
+
+	profile->calls = __atomic_load_n(&profiles[proto].calls, 
+			__ATOMIC_RELAXED);
+	profile->matches = __atomic_load_n(&profiles[proto].matches, 
+			__ATOMIC_RELAXED);
+	profile->ticks = __atomic_load_n(&profiles[proto].ticks, 
+			__ATOMIC_RELAXED);
+	return 0;
+}
+
 lpi_category_t lpi_categorise(lpi_module_t *module) {
 
 	if (module == NULL)
@@ -439,27 +1631,36 @@ const char *lpi_print_category(lpi_category_t category) {
 			
 const char *lpi_print(lpi_protocol_t proto) {
 
-	LPINameMap::iterator it;
-
-	it = lpi_names.find(proto);
-
-	if (it == lpi_names.end()) {
+	if ((unsigned int)proto >= LPI_PROTO_LAST || lpi_names[proto] == NULL)
 		return "NULL";
-	}	
-	return (it->second);
+	return lpi_names[proto];
 	
 }
 
 bool lpi_is_protocol_inactive(lpi_protocol_t proto) {
 
-	LPINameMap::iterator it;
-
-	it = lpi_names.find(proto);
-
-	if (it == lpi_names.end()) {
+	if ((unsigned int)proto >= LPI_PROTO_LAST || lpi_names[proto] == NULL)
 		return true;
-	}	
 	return false;
 
 }
 
+lpi_protocol_t lpi_protocol_by_name(const char *name) {
+
+	uint32_t seed, slot;
+	uint16_t proto;
+
+	if (name == NULL || name_hash.table == NULL)
+		return LPI_PROTO_LAST;
+
+	seed = name_hash.seeds[hash_name(name, 0) & (name_hash.buckets - 1)];
+	if (seed == 0)
+		return LPI_PROTO_LAST;
+
+	slot = hash_name(name, seed) & (name_hash.slots - 1);
+	proto = name_hash.table[slot];
+	if (proto == LPI_PROTO_LAST || strcasecmp(lpi_names[proto], name) != 0)
+		return LPI_PROTO_LAST;
+	return (lpi_protocol_t)proto;
+}
+
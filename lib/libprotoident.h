@@ -52,8 +52,6 @@
 #  define PRINTF(formatpos,argpos) 
 #endif
 
-#define DEFAULT_MAXTHREADS 10
-
 #ifdef __cplusplus 
 extern "C" {
 #endif
@@ -114,6 +112,10 @@ typedef enum {
 	LPI_CATEGORY_LAST		/* Must always be last */
 } lpi_category_t;
 
+/* Bitmasks for use with lpi_set_category_mask() */
+#define LPI_CATEGORY_MASK(cat) (((uint64_t)1) << (cat))
+#define LPI_CATEGORY_MASK_ALL (~((uint64_t)0))
+
 
 typedef enum {
         /* TCP Protocols */
@@ -423,24 +425,166 @@ typedef enum {
 	LPI_PROTO_LAST		/** ALWAYS have this as the last value */
 } lpi_protocol_t;
 
+/* Full IPv6 addresses for a flow. This is not part of lpi_data_t itself,
+ * so that IPv4 flows do not have to pay for the extra 32 bytes. Callers that
+ * want the full addresses can attach one of these to the flow by setting
+ * the ip6 member of lpi_data_t after calling lpi_init_data(). */
+typedef struct lpi_ip6 {
+	uint8_t addr[2][16];
+} lpi_ip6_t;
+
+/* The version of the lpi_data_t layout described below. This changes 
+ * whenever the members of lpi_data_t are changed, so that code that keeps
+ * copies of the structure (e.g. in shared memory) can tell whether they 
+ * were written by a compatible version of the library */
+#define LPI_DATA_VERSION 4
+
+/* The largest number of bytes that can be kept for each direction when 
+ * extended payload capture is enabled */
+#define LPI_MAX_PAYLOAD_CAPTURE 256
+
+/* The largest number of packet sizes that can be recorded for a flow */
+#define LPI_MAX_SIZE_SEQUENCE 32
+
 /* This structure stores all the data needed by libprotoident to identify the
  * application protocol for a flow. Do not change the contents of this struct
  * directly - lpi_update_data() will do that for you - but reading the values
- * should be ok. */
+ * should be ok. 
+ *
+ * For IPv4 flows, ips contains the addresses of each endpoint. For IPv6
+ * flows, ips contains the last four bytes of each address, which is
+ * where an IPv4 address is embedded in IPv4-mapped and IPv4-compatible
+ * addresses. ip_version says which of the two applies (0 if no address has
+ * been seen yet). 
+ *
+ * If extended payload capture or packet size sequences have been enabled
+ * (see lpi_set_payload_capture() and lpi_set_size_sequence()), ext_slot 
+ * refers to the buffer holding the extra state for the flow. Use 
+ * lpi_get_payload_prefix() and lpi_get_size_sequence() to read it.
+ *
+ * If a later TCP segment arrives before the first one in a direction, the
+ * later segment is recorded but held for a few packets in case the first
+ * segment turns up after all. The same applies to the first payload in a
+ * direction whose SYN was not seen. hold_count is non-zero while this is 
+ * the case. Once the hold ends, the payload for that direction is never
+ * changed again.
+ *
+ * The members are ordered from largest to smallest so that there are no
+ * padding holes -- the structure uses 63 of its 64 bytes on 64-bit 
+ * systems. */
 typedef struct lpi {
 	uint32_t payload[2];
-	bool seen_syn[2];
-	uint32_t seqno[2];
+	uint32_t payload_len[2];
 	uint32_t observed[2];
+	uint32_t seqno[2];
+	uint32_t ips[2];
+	lpi_ip6_t *ip6;
+	uint32_t ext_slot;
 	uint16_t server_port;
 	uint16_t client_port;
 	uint8_t trans_proto;
-	uint32_t payload_len[2];
-	uint32_t ips[2];
+	uint8_t ip_version;
+	bool seen_syn[2];
+	uint8_t version;	/* Always LPI_DATA_VERSION */
+	uint8_t hold_count[2];
 } lpi_data_t;
 
 typedef struct lpi_module lpi_module_t;
 
+/* The size and direction of a payload-bearing packet, as recorded when 
+ * packet size sequences are enabled */
+typedef struct lpi_packet_size {
+	uint16_t size;		/* Payload length, capped at 65535 */
+	uint8_t dir;		/* Direction of the packet */
+} lpi_packet_size_t;
+
+/* Tunnels that lpi_update_data() can look inside, if asked to */
+typedef enum {
+	LPI_ENCAP_GRE,		/* GRE carrying IP or Ethernet */
+	LPI_ENCAP_IPIP,		/* IPv4 or IPv6 directly inside IP */
+	LPI_ENCAP_VXLAN,	/* VXLAN on UDP port 4789 */
+	LPI_ENCAP_TEREDO,	/* Teredo on UDP port 3544 */
+	LPI_ENCAP_LAST		/* Must always be last */
+} lpi_encap_t;
+
+#define LPI_ENCAP_MASK(e) (1U << (e))
+
+/* The innermost packet found inside a tunnel by lpi_decapsulate(). The
+ * pointers all point into the original packet */
+typedef struct lpi_inner {
+	const uint8_t *l3;	/* Start of the inner IP header */
+	uint16_t ethertype;	/* Type of the inner IP header */
+	const uint8_t *l4;	/* Start of the inner transport header */
+	uint8_t proto;		/* Inner transport protocol */
+	uint32_t l4_rem;	/* Captured bytes from l4 onwards */
+	uint32_t payload_len;	/* Inner application payload length */
+} lpi_inner_t;
+
+/* Counters for the tunnels that have been removed by lpi_update_data() */
+typedef struct lpi_decap_stats {
+	uint64_t packets[LPI_ENCAP_LAST];	/* Packets decapsulated, for
+						   each lpi_encap_t */
+} lpi_decap_stats_t;
+
+/* A classifier context -- the set of modules that will be tried when 
+ * guessing the protocol for a flow. The contents are private to the
+ * library */
+typedef struct lpi_context lpi_context_t;
+
+/* Describes how a module uses the port numbers of a flow. Modules that do
+ * not say anything about ports are treated as being port-agnostic.
+ *
+ * If a module is marked as LPI_PORTS_REQUIRED, the callback must never
+ * return true unless either the server or client port appears in the 
+ * module's port list. This allows libprotoident to skip the callback
+ * entirely for flows on other ports.
+ *
+ * LPI_PORTS_PREFERRED is purely informational -- the rule is usually seen
+ * on the listed ports but is able to match flows on other ports too, so
+ * the callback is always run.
+ */
+typedef enum {
+	LPI_PORTS_AGNOSTIC = 0,	/* Rule does not care about port numbers */
+	LPI_PORTS_REQUIRED,	/* Rule can only match on the listed ports */
+	LPI_PORTS_PREFERRED	/* Rule favours the listed ports */
+} lpi_port_hint_t;
+
+/* A masked 4-byte payload signature, with optional payload length bounds.
+ *
+ * If a module provides a list of signatures, the callback must never 
+ * return true unless the first four bytes of payload in at least one 
+ * direction match one of the signatures, i.e. (payload & mask) == value 
+ * and the payload length lies within [min_len, max_len]. A max_len of 
+ * zero means there is no upper bound. The list is terminated by an entry
+ * with a zero mask.
+ *
+ * This allows libprotoident to skip the callback for flows that begin 
+ * with some other payload. Modules without signatures are always tried.
+ */
+typedef struct lpi_signature {
+	uint32_t value;		/* Expected payload, after masking */
+	uint32_t mask;		/* Payload bits to compare */
+	uint32_t min_len;	/* Minimum payload length */
+	uint32_t max_len;	/* Maximum payload length, 0 = no limit */
+} lpi_signature_t;
+
+/* A range of payload lengths, from min_len to max_len inclusive.
+ *
+ * A module can give two lists of these to describe the payload lengths
+ * that it can match. If it does, the callback must never return true 
+ * unless the payload length in one direction lies within a range from the
+ * first list and the length in the other direction lies within a range 
+ * from the second list. A NULL list accepts any length. Each list is 
+ * terminated by an entry where min_len is greater than max_len.
+ *
+ * This allows libprotoident to skip the callback for flows with other
+ * payload lengths, without looking at the payload at all. 
+ */
+typedef struct lpi_length_range {
+	uint32_t min_len;
+	uint32_t max_len;
+} lpi_length_range_t;
+
 /* This structure describes an individual LPI module - i.e. a protocol 
  * supported by libprotoident */
 struct lpi_module {
@@ -454,18 +598,103 @@ struct lpi_module {
 	 * data matches the ruleset for this protocol */
         bool (*lpi_callback) (lpi_data_t *proto_d, lpi_module_t *module);
 
+	/* Optional port hints for this module - see lpi_port_hint_t */
+	lpi_port_hint_t port_hint;
+	const uint16_t *ports;		/* Zero-terminated list of ports */
+
+	/* Optional payload signatures for this module - see 
+	 * lpi_signature_t */
+	const lpi_signature_t *signatures;
+
+	/* Optional payload lengths for this module - see 
+	 * lpi_length_range_t */
+	const lpi_length_range_t *lengths[2];
+
 };
 
 typedef std::list<lpi_module_t *> ProtoMatchList;
 
-typedef struct lpi_thread {
-	int index;
-	lpi_module_t *module;
-	lpi_data_t *data;
-	bool result;
-} lpi_thread_t;
+/* Profiling counters for an individual module */
+typedef struct lpi_module_profile {
+	uint64_t calls;		/* Number of times the module was tried */
+	uint64_t matches;	/* Number of times the module matched */
+	uint64_t ticks;		/* Total time spent in the module -- CPU 
+				   cycles on x86, nanoseconds elsewhere */
+} lpi_module_profile_t;
+
+/* Counters for a classifier context's result cache */
+typedef struct lpi_cache_stats {
+	uint32_t entries;	/* Size of the cache, zero if disabled */
+	uint64_t hits;		/* Flows found in the cache */
+	uint64_t misses;	/* Flows that had to be classified */
+	uint64_t bypassed;	/* Flows that could not use the cache */
+} lpi_cache_stats_t;
+
+/* Counters for the handling of TCP segments that arrive out of order 
+ * before the first payload in a direction has been recorded */
+typedef struct lpi_reorder_stats {
+	uint64_t held;		/* Segments held in case an earlier one 
+				   turns up, including the first payload
+				   seen without a SYN */
+	uint64_t repaired;	/* Payloads replaced by an earlier segment */
+	uint64_t committed;	/* Held segments kept because no earlier 
+				   one turned up in time */
+} lpi_reorder_stats_t;
+
+/* A pool of worker threads that classify flows on behalf of the caller */
+typedef struct lpi_pool lpi_pool_t;
+
+/* A classification request that has been completed by a worker pool */
+typedef struct lpi_pool_result {
+	lpi_data_t *data;		/* The LPI data that was submitted */
+	void *user;			/* The user pointer that was submitted */
+	lpi_module_t *module;		/* The protocol for the flow */
+} lpi_pool_result_t;
 
-typedef std::list<pthread_t> ThreadList;
+/* Counters for an individual worker thread within a pool */
+typedef struct lpi_pool_worker_stats {
+	uint64_t classified;		/* Flows classified by this worker */
+	uint64_t stolen;		/* Flows taken from another worker's queue */
+	uint32_t queue_depth;		/* Requests waiting in this worker's queue */
+	uint32_t results_waiting;	/* Results not yet collected */
+} lpi_pool_worker_stats_t;
+
+/* Counters for a worker pool as a whole */
+typedef struct lpi_pool_stats {
+	uint32_t nthreads;		/* Number of worker threads */
+	uint64_t submitted;		/* Requests accepted by lpi_pool_submit */
+	uint64_t rejected;		/* Requests refused as the queues were full */
+	uint64_t completed;		/* Results returned by lpi_pool_complete */
+	uint32_t queue_depth;		/* Requests waiting to be classified */
+	uint32_t results_waiting;	/* Results not yet collected */
+} lpi_pool_stats_t;
+
+/* LPI data for a set of flows, stored as a structure of arrays rather than
+ * an array of lpi_data_t -- each array is indexed by flow. This is more 
+ * compact than keeping an lpi_data_t in each flow (53 bytes per flow 
+ * rather than 64) and keeps the same member of neighbouring flows together
+ * in memory, which suits code that scans many flows at once.
+ *
+ * The full IPv6 addresses are not kept, so any lpi_ip6_t attached to the
+ * lpi_data_t passed to lpi_flow_batch_store() is ignored. Any buffers used
+ * for extended payload capture are released when the batch is cleared or
+ * destroyed. */
+typedef struct lpi_flow_batch {
+	uint32_t size;			/* The number of flows that fit */
+	uint32_t count;			/* The number of flows in use */
+	uint32_t *payload[2];
+	uint32_t *payload_len[2];
+	uint32_t *observed[2];
+	uint32_t *seqno[2];
+	uint32_t *ips[2];
+	uint32_t *ext_slot;
+	uint16_t *server_port;
+	uint16_t *client_port;
+	uint8_t *trans_proto;
+	uint8_t *ip_version;
+	uint8_t *seen_syn;		/* Bit n is set if seen_syn[n] is */
+	uint8_t *hold_count[2];
+} lpi_flow_batch_t;
 
 /* Initialises the LPI library, by registering all the protocol modules.
  *
@@ -473,7 +702,9 @@ typedef std::list<pthread_t> ThreadList;
  */
 int lpi_init_library(void);
 
-/* Shuts down the LPI library, by de-registering all the protocol modules */
+/* Shuts down the LPI library, by de-registering all the protocol modules.
+ * The buffers used for extended payload capture and packet size sequences
+ * are only freed if no flows are still holding one (see lpi_free_data()) */
 void lpi_free_library(void);
 
 /** Initialises an LPI data structure, setting all the members to appropriate
@@ -483,12 +714,30 @@ void lpi_free_library(void);
  */
 void lpi_init_data(lpi_data_t *data);
 
+/** Releases any resources held by an LPI data structure, i.e. the buffer 
+ *  used for extended payload capture and packet size sequences. This must
+ *  be called before discarding the LPI data for a flow if either of those
+ *  is enabled, and does nothing otherwise.
+ *
+ *  @param data	The LPI data structure to be released.
+ */
+void lpi_free_data(lpi_data_t *data);
+
 /** Updates the LPI data structure based on the contents of the packet
  *  provided.
  *
  *  @note The direction must be provided by the caller, as we cannot rely
  *  on trace_get_direction().
  *
+ *  If decapsulation has been enabled with lpi_set_decapsulation() and the
+ *  packet is carried by one of the selected tunnels, the LPI data is 
+ *  updated using the TCP or UDP packet inside the tunnel instead. Only 
+ *  the inner flow that the first such packet belongs to is followed; 
+ *  packets from any other flow in the same tunnel are ignored. Callers 
+ *  that want every inner flow classified should find the inner headers 
+ *  with lpi_decapsulate(), key their flows on those and pass the packets
+ *  in using lpi_update_data_raw() or lpi_update_data_raw6().
+ *
  *  @param packet The packet to update the LPI data from.
  *  @param data	The LPI data structure to be updated.
  *  @param dir The direction of the packet - 0 is outgoing, 1 is incoming.
@@ -497,6 +746,122 @@ void lpi_init_data(lpi_data_t *data);
  */
 int lpi_update_data(libtrace_packet_t *packet, lpi_data_t *data, uint8_t dir);
 
+/** Finds the innermost TCP or UDP packet carried inside any of the tunnels
+ *  that have been enabled using lpi_set_decapsulation(). Nothing is copied;
+ *  the inner headers are located within the original packet.
+ *
+ *  Tunnels that do not contain TCP or UDP, e.g. Teredo bubbles or GRE 
+ *  keepalives, are left alone so that they are identified as the tunnel
+ *  protocol itself.
+ *
+ *  @param packet	The packet to look inside.
+ *  @param inner	Populated with the location of the inner headers.
+ *
+ *  @return The number of tunnels removed to reach the inner packet, or 0
+ *  if the packet is not tunnelled (in which case inner is not modified).
+ */
+int lpi_decapsulate(libtrace_packet_t *packet, lpi_inner_t *inner);
+
+/** Updates the LPI data structure using headers that the caller has already
+ *  located, so the packet does not need to be parsed again. This also 
+ *  allows packets to be passed in that did not come from libtrace.
+ *
+ *  @param data		The LPI data structure to be updated.
+ *  @param proto	The transport protocol, e.g. 6 for TCP.
+ *  @param l4hdr	A pointer to the start of the transport header.
+ *  @param l4_rem	The number of captured bytes, starting from l4hdr.
+ *  @param payload_len	The amount of application payload in the packet,
+ *  			which may be more than was captured.
+ *  @param src_ip	The source IPv4 address, in network byte order, or 0
+ *  			if the packet is not IPv4.
+ *  @param dst_ip	The destination IPv4 address, in network byte order,
+ *  			or 0 if the packet is not IPv4.
+ *  @param dir		The direction of the packet - 0 is outgoing, 1 is 
+ *  			incoming.
+ *
+ *  @return 0 if the packet was ignored, 1 if the LPI data was updated.
+ */
+int lpi_update_data_raw(lpi_data_t *data, uint8_t proto, const void *l4hdr,
+		uint32_t l4_rem, uint32_t payload_len, uint32_t src_ip, 
+		uint32_t dst_ip, uint8_t dir);
+
+/** Updates the LPI data structure using headers that the caller has already
+ *  located, in the same way as lpi_update_data_raw(), for an IPv6 packet.
+ *
+ *  If an lpi_ip6_t has been attached to the LPI data structure, the full
+ *  addresses are copied into it as well.
+ *
+ *  @param data		The LPI data structure to be updated.
+ *  @param proto	The transport protocol, e.g. 6 for TCP.
+ *  @param l4hdr	A pointer to the start of the transport header.
+ *  @param l4_rem	The number of captured bytes, starting from l4hdr.
+ *  @param payload_len	The amount of application payload in the packet,
+ *  			which may be more than was captured.
+ *  @param src_ip6	The 16 byte source IPv6 address, or NULL.
+ *  @param dst_ip6	The 16 byte destination IPv6 address, or NULL.
+ *  @param dir		The direction of the packet - 0 is outgoing, 1 is 
+ *  			incoming.
+ *
+ *  @return 0 if the packet was ignored, 1 if the LPI data was updated.
+ */
+int lpi_update_data_raw6(lpi_data_t *data, uint8_t proto, const void *l4hdr,
+		uint32_t l4_rem, uint32_t payload_len, const uint8_t *src_ip6,
+		const uint8_t *dst_ip6, uint8_t dir);
+
+/** Determines whether the LPI data for a flow is complete, i.e. whether 
+ *  passing any further packets for the flow to lpi_update_data() would 
+ *  make a difference to the protocol that it is identified as.
+ *
+ *  This is the case once the first payload has been seen in both 
+ *  directions (or one direction has sent too much without any payload 
+ *  being seen) and any packet size sequence is full, so callers can use 
+ *  it to avoid parsing the remaining packets of a long flow at all. Note 
+ *  that the observed byte counts are not updated once lpi_update_data() 
+ *  is no longer being called.
+ *
+ *  @param data		The LPI data for the flow.
+ *
+ *  @return true if the LPI data is complete, false otherwise.
+ */
+bool lpi_data_is_complete(lpi_data_t *data);
+
+/** Returns the start of the first payload seen in a given direction. 
+ *
+ *  If extended payload capture is enabled, this will be up to the 
+ *  configured number of bytes. Otherwise, or if no buffer could be 
+ *  allocated for the flow, it is the same four bytes as data->payload.
+ *
+ *  @param data		The LPI data for the flow.
+ *  @param dir		The direction to return the payload for.
+ *  @param bytes	Set to point at the captured payload.
+ *
+ *  @return The number of bytes of payload available at *bytes, which is 
+ *  never more than the payload length for that direction.
+ */
+uint32_t lpi_get_payload_prefix(lpi_data_t *data, uint8_t dir, 
+		const uint8_t **bytes);
+
+/** Returns the sizes and directions of the first payload-bearing packets 
+ *  seen for a flow, in the order they were passed to lpi_update_data().
+ *
+ *  @param data		The LPI data for the flow.
+ *  @param seq		An array to write the packet sizes into.
+ *  @param max		The maximum number of entries to write.
+ *
+ *  @return The number of entries written, which is zero if packet size 
+ *  sequences are not enabled.
+ */
+uint32_t lpi_get_size_sequence(lpi_data_t *data, lpi_packet_size_t *seq,
+		uint32_t max);
+
+/** Reports how often lpi_update_data() has had to deal with TCP segments
+ *  arriving out of order before the first payload in a direction was 
+ *  recorded. The counters cover every flow since the program started.
+ *
+ *  @param stats	Populated with the reordering counters.
+ */
+void lpi_get_reorder_stats(lpi_reorder_stats_t *stats);
+
 /** Returns a unique string describing the provided protocol.
  *
  * This is essentially a protocol-to-string conversion function.
@@ -539,6 +904,434 @@ const char *lpi_print_category(lpi_category_t category);
  */
 lpi_module_t *lpi_guess_protocol(lpi_data_t *data);
 
+/** Same as lpi_guess_protocol(), but also reports whether the answer is 
+ *  final.
+ *
+ *  Libprotoident only ever looks at the first payload-bearing packet in 
+ *  each direction, so once both directions have been seen (or one of them
+ *  can no longer be), passing further packets to lpi_update_data() will 
+ *  not change the result. Callers can use this to stop updating and 
+ *  re-guessing flows that have been settled.
+ *
+ *  @param data		The LPI data to use when determining the protocol.
+ *  @param final	Set to true if the result cannot change given any
+ *  			further packets for this flow, false otherwise.
+ *
+ *  @return The LPI module for the protocol that matches the profile 
+ *  described by the given LPI data.
+ */
+lpi_module_t *lpi_guess_protocol_ex(lpi_data_t *data, bool *final);
+
+/** Determines the L7 protocol for each flow in an array of flows.
+ *
+ *  This gives exactly the same results as calling lpi_guess_protocol() on
+ *  each flow in turn, but is cheaper when there are a lot of flows to
+ *  classify at once, e.g. when a large number of flows expire together.
+ *  Each module is tried against every flow in the batch before moving on 
+ *  to the next module.
+ *
+ *  @param flows	An array of pointers to the LPI data for each flow.
+ *  @param n		The number of flows in the array.
+ *  @param out		An array of at least n module pointers, which will
+ *  			be populated with the protocol for each flow.
+ *
+ *  @return 0 if the flows were classified successfully, -1 if an error
+ *  occurred.
+ */
+int lpi_guess_protocol_batch(lpi_data_t **flows, size_t n, 
+		lpi_module_t **out);
+
+/** Creates a new classifier context, which can be used to guess protocols
+ *  independently of the default context used by lpi_guess_protocol().
+ *
+ *  A context is never modified after it has been created, so a single 
+ *  context can be used by multiple threads at once. lpi_init_library() 
+ *  must be called before creating any contexts and all contexts must be 
+ *  destroyed before calling lpi_free_library().
+ *
+ *  @param enabled	An array of LPI_PROTO_LAST booleans, indexed by 
+ *  			protocol, describing which protocols should be tried
+ *  			by this context. If NULL, all protocols are enabled.
+ *
+ *  @return A pointer to the new context, or NULL if an error occurred.
+ */
+lpi_context_t *lpi_ctx_create(const bool *enabled);
+
+/** Destroys a classifier context created using lpi_ctx_create().
+ *
+ *  @param ctx		The context to destroy.
+ */
+void lpi_ctx_destroy(lpi_context_t *ctx);
+
+/** Same as lpi_guess_protocol(), but only tries the protocols enabled in
+ *  the given context. 
+ *
+ *  @param ctx		The context to use.
+ *  @param data		The LPI data to use when determining the protocol.
+ *
+ *  @return The LPI module for the protocol that matches the profile 
+ *  described by the given LPI data.
+ */
+lpi_module_t *lpi_ctx_guess(lpi_context_t *ctx, lpi_data_t *data);
+
+/** Same as lpi_guess_protocol_ex(), but only tries the protocols enabled 
+ *  in the given context.
+ *
+ *  @param ctx		The context to use.
+ *  @param data		The LPI data to use when determining the protocol.
+ *  @param final	Set to true if the result cannot change given any
+ *  			further packets for this flow, false otherwise.
+ *
+ *  @return The LPI module for the protocol that matches the profile 
+ *  described by the given LPI data.
+ */
+lpi_module_t *lpi_ctx_guess_ex(lpi_context_t *ctx, lpi_data_t *data, 
+		bool *final);
+
+/** Same as lpi_guess_protocol_batch(), but only tries the protocols 
+ *  enabled in the given context.
+ *
+ *  @param ctx		The context to use.
+ *  @param flows	An array of pointers to the LPI data for each flow.
+ *  @param n		The number of flows in the array.
+ *  @param out		An array of at least n module pointers, which will
+ *  			be populated with the protocol for each flow.
+ *
+ *  @return 0 if the flows were classified successfully, -1 if an error
+ *  occurred.
+ */
+int lpi_ctx_guess_batch(lpi_context_t *ctx, lpi_data_t **flows, size_t n,
+		lpi_module_t **out);
+
+/** Enables or disables a protocol for the default context. The dispatch
+ *  tables are rebuilt immediately, so disabled modules cost nothing when 
+ *  guessing protocols. Flows that would have matched a disabled module 
+ *  will match a lower priority module or be reported as unknown instead.
+ *
+ *  This must not be called while other threads are guessing protocols
+ *  using the default context.
+ *
+ *  @param proto	The protocol to enable or disable.
+ *  @param enabled	If true, enable the protocol. Otherwise, disable it.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_protocol_enabled(lpi_protocol_t proto, bool enabled);
+
+/** Sets the categories of protocol that are enabled for the default 
+ *  context. A module is only tried if both its protocol and its category
+ *  are enabled. All categories are enabled by default.
+ *
+ *  This must not be called while other threads are guessing protocols
+ *  using the default context.
+ *
+ *  @param mask		A bitmask of enabled categories, built using 
+ *  			LPI_CATEGORY_MASK().
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_category_mask(uint64_t mask);
+
+/** Enables, resizes or disables the result cache for the default context.
+ *
+ *  The cache remembers the protocol matched by recent flows, keyed on 
+ *  the fields of the LPI data that the rules look at (the payload, payload
+ *  lengths, ports and transport protocol). Flows that look exactly like a
+ *  recent flow are then classified without trying any modules. Flows that
+ *  could match a rule that depends on their IP addresses never use the 
+ *  cache. Cached results are discarded whenever the set of enabled 
+ *  modules changes. The cache is disabled by default, and is not used 
+ *  while profiling is enabled.
+ *
+ *  The cache itself may be used by any number of threads at once, but 
+ *  this function must not be called while other threads are guessing
+ *  protocols using the default context.
+ *
+ *  @param entries	The number of results to keep, rounded up to a 
+ *  			power of two. Zero disables the cache.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_cache_size(uint32_t entries);
+
+/** Same as lpi_set_cache_size(), but for the given context.
+ *
+ *  @param ctx		The context to configure.
+ *  @param entries	The number of results to keep, or zero to disable
+ *  			the cache.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_ctx_set_cache_size(lpi_context_t *ctx, uint32_t entries);
+
+/** Enables or disables extended payload capture.
+ *
+ *  By default, only the first four bytes of payload are kept for each
+ *  direction. With extended capture enabled, lpi_update_data() also copies
+ *  up to the given number of bytes into a per-flow buffer taken from a 
+ *  pool managed by the library, which modules can use to check more than
+ *  the first four bytes. Flows using the buffers must be released with 
+ *  lpi_free_data(). The result cache is not used for flows that have a
+ *  buffer.
+ *
+ *  The setting can only be changed while no flows hold a buffer.
+ *
+ *  @param bytes	The number of bytes to capture for each direction,
+ *  			up to LPI_MAX_PAYLOAD_CAPTURE. Zero (or anything up 
+ *  			to four) disables extended capture.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_payload_capture(uint32_t bytes);
+
+/** Enables or disables packet size sequences.
+ *
+ *  When enabled, lpi_update_data() records the size and direction of the
+ *  first few payload-bearing packets of each flow, using the same per-flow
+ *  buffers as extended payload capture (so flows must also be released 
+ *  with lpi_free_data()). lpi_data_is_complete() will not report a flow as
+ *  complete until its sequence is full.
+ *
+ *  The setting can only be changed while no flows hold a buffer.
+ *
+ *  @param packets	The number of packets to record for each flow, up 
+ *  			to LPI_MAX_SIZE_SEQUENCE. Zero disables recording.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_size_sequence(uint32_t packets);
+
+/** Selects the tunnels that lpi_update_data() should look inside. By 
+ *  default, no tunnels are removed and the outer headers are used.
+ *
+ *  @param mask		The tunnels to remove, as a combination of 
+ *  			LPI_ENCAP_MASK() values. Zero disables decapsulation.
+ *
+ *  @return 0 if successful, -1 if an error occurred.
+ */
+int lpi_set_decapsulation(uint32_t mask);
+
+/** Returns a string describing the provided tunnel type, e.g. "GRE".
+ *
+ *  @param encap	The tunnel type.
+ *
+ *  @return A pointer to a statically allocated string.
+ */
+const char *lpi_print_encap(lpi_encap_t encap);
+
+/** Reports how many packets have been taken out of each type of tunnel by
+ *  lpi_update_data(). A packet that was inside several tunnels is counted
+ *  once for each of them.
+ *
+ *  @param stats	Populated with the decapsulation counters.
+ */
+void lpi_get_decap_stats(lpi_decap_stats_t *stats);
+
+/** Reports the counters for the default context's result cache. The 
+ *  counters are all zero if the cache is disabled.
+ *
+ *  @param stats	Populated with the cache counters.
+ */
+void lpi_get_cache_stats(lpi_cache_stats_t *stats);
+
+/** Same as lpi_get_cache_stats(), but for the given context.
+ *
+ *  @param ctx		The context to report on.
+ *  @param stats	Populated with the cache counters.
+ */
+void lpi_ctx_get_cache_stats(lpi_context_t *ctx, lpi_cache_stats_t *stats);
+
+/** Returns the category for a given protocol.
+ *
+ *  @param proto	The protocol to look up.
+ *
+ *  @return The category that the protocol belongs to.
+ */
+lpi_category_t lpi_categorise_protocol(lpi_protocol_t proto);
+
+/** Enables or disables module profiling. While profiling is enabled, the
+ *  library records how many times each module is tried, how many times it
+ *  matches and how long it takes. Profiling is disabled by default.
+ *
+ *  @param enabled	If true, enable profiling. Otherwise, disable it.
+ */
+void lpi_set_profiling(bool enabled);
+
+/** Resets the profiling counters for every module back to zero. */
+void lpi_reset_module_profiles(void);
+
+/** Reports the profiling counters for the module for a given protocol.
+ *
+ *  @param proto	The protocol to report on.
+ *  @param profile	Populated with the counters for the module.
+ *
+ *  @return 0 if successful, -1 if the protocol is invalid.
+ */
+int lpi_get_module_profile(lpi_protocol_t proto, 
+		lpi_module_profile_t *profile);
+
+/** Creates a pool of worker threads for classifying flows, so that the 
+ *  thread reading packets can hand the classification of expired flows 
+ *  off to other threads.
+ *
+ *  Requests are submitted using lpi_pool_submit() and the results are 
+ *  collected using lpi_pool_complete(). Both functions must always be 
+ *  called from the same thread. Each worker has its own queue of requests,
+ *  but an idle worker will steal requests from the queues of busy workers.
+ *
+ *  @param nthreads	The number of worker threads to start.
+ *
+ *  @return A pointer to the new pool, or NULL if an error occurred.
+ */
+lpi_pool_t *lpi_pool_create(int nthreads);
+
+/** Same as lpi_pool_create(), but the workers will classify flows using the
+ *  given context instead of the default one. The context must not be 
+ *  destroyed until the pool has been destroyed.
+ *
+ *  @param ctx		The context to use when classifying flows.
+ *  @param nthreads	The number of worker threads to start.
+ *
+ *  @return A pointer to the new pool, or NULL if an error occurred.
+ */
+lpi_pool_t *lpi_pool_create_ctx(lpi_context_t *ctx, int nthreads);
+
+/** Submits a flow to a worker pool for classification. The LPI data must not
+ *  be modified or freed until the result has been returned by
+ *  lpi_pool_complete().
+ *
+ *  @param pool		The pool to submit the flow to.
+ *  @param data		The LPI data for the flow.
+ *  @param user		A pointer that will be returned along with the 
+ *  			result, e.g. the flow that the data belongs to.
+ *
+ *  @return 0 if the flow was queued, -1 if every queue is full. In the 
+ *  latter case, the caller should collect some results using 
+ *  lpi_pool_complete() (or classify the flow itself) and try again.
+ */
+int lpi_pool_submit(lpi_pool_t *pool, lpi_data_t *data, void *user);
+
+/** Collects classification results from a worker pool. This function never
+ *  blocks -- if no results are available, it will return zero.
+ *
+ *  Workers cannot complete any more requests once their result queue is 
+ *  full, so this should be called regularly.
+ *
+ *  @param pool		The pool to collect results from.
+ *  @param results	An array to write the results into.
+ *  @param max		The maximum number of results to write.
+ *
+ *  @return The number of results written into the array.
+ */
+int lpi_pool_complete(lpi_pool_t *pool, lpi_pool_result_t *results, int max);
+
+/** Reports the counters for a worker pool.
+ *
+ *  @param pool		The pool to report on.
+ *  @param stats	Populated with the counters for the pool as a whole.
+ *  @param workers	If not NULL, an array of at least nthreads entries
+ *  			that will be populated with the counters for each 
+ *  			worker.
+ */
+void lpi_pool_get_stats(lpi_pool_t *pool, lpi_pool_stats_t *stats,
+		lpi_pool_worker_stats_t *workers);
+
+/** Stops the worker threads and frees a worker pool. Any requests that have
+ *  not been completed, or whose results have not been collected, are
+ *  discarded.
+ *
+ *  @param pool		The pool to destroy.
+ */
+void lpi_pool_destroy(lpi_pool_t *pool);
+
+/** Creates a new flow batch, which stores the LPI data for a number of
+ *  flows as a structure of arrays. 
+ *
+ *  @param size		The maximum number of flows in the batch.
+ *
+ *  @return A pointer to the new batch, or NULL if an error occurred.
+ */
+lpi_flow_batch_t *lpi_flow_batch_create(uint32_t size);
+
+/** Frees a flow batch.
+ *
+ *  @param batch	The batch to free.
+ */
+void lpi_flow_batch_destroy(lpi_flow_batch_t *batch);
+
+/** Adds a new flow to a flow batch. The LPI data for the new flow is
+ *  initialised in the same way as lpi_init_data().
+ *
+ *  @param batch	The batch to add the flow to.
+ *
+ *  @return The index of the new flow, or -1 if the batch is full.
+ */
+int lpi_flow_batch_add(lpi_flow_batch_t *batch);
+
+/** Removes all of the flows from a flow batch.
+ *
+ *  @param batch	The batch to clear.
+ */
+void lpi_flow_batch_clear(lpi_flow_batch_t *batch);
+
+/** Copies the LPI data for a flow out of a flow batch.
+ *
+ *  @param batch	The batch containing the flow.
+ *  @param idx		The index of the flow.
+ *  @param data		The LPI data structure to populate.
+ */
+void lpi_flow_batch_load(lpi_flow_batch_t *batch, uint32_t idx, 
+		lpi_data_t *data);
+
+/** Copies the LPI data for a flow into a flow batch.
+ *
+ *  @param batch	The batch containing the flow.
+ *  @param idx		The index of the flow.
+ *  @param data		The LPI data to store.
+ */
+void lpi_flow_batch_store(lpi_flow_batch_t *batch, uint32_t idx,
+		const lpi_data_t *data);
+
+/** Updates the LPI data for a flow in a flow batch based on the contents of
+ *  the provided packet, in the same way as lpi_update_data().
+ *
+ *  @param batch	The batch containing the flow.
+ *  @param idx		The index of the flow.
+ *  @param packet	The packet to update the LPI data from.
+ *  @param dir		The direction of the packet - 0 is outgoing, 1 is 
+ *  			incoming.
+ *
+ *  @return 0 if the packet was ignored, 1 if the LPI data was updated.
+ */
+int lpi_flow_batch_update(lpi_flow_batch_t *batch, uint32_t idx,
+		libtrace_packet_t *packet, uint8_t dir);
+
+/** Guesses the protocol for every flow in a flow batch, in the same way as
+ *  lpi_guess_protocol_batch().
+ *
+ *  @param batch	The batch containing the flows.
+ *  @param out		An array of at least batch->count module pointers,
+ *  			which will be populated with the protocol for each
+ *  			flow.
+ *
+ *  @return 0 if the flows were classified successfully, -1 if an error
+ *  occurred.
+ */
+int lpi_flow_batch_guess(lpi_flow_batch_t *batch, lpi_module_t **out);
+
+/** Same as lpi_flow_batch_guess(), but uses the given context instead of 
+ *  the default one.
+ *
+ *  @param ctx		The context to use when classifying the flows.
+ *  @param batch	The batch containing the flows.
+ *  @param out		An array of at least batch->count module pointers.
+ *
+ *  @return 0 if the flows were classified successfully, -1 if an error
+ *  occurred.
+ */
+int lpi_ctx_flow_batch_guess(lpi_context_t *ctx, lpi_flow_batch_t *batch,
+		lpi_module_t **out);
+
 /** Determines whether the protocol matching a given protocol number is no
  *  longer supported by libprotoident.
  *
@@ -559,6 +1352,19 @@ lpi_module_t *lpi_guess_protocol(lpi_data_t *data);
  *  to avoid reporting anything for the NULL protocols.
  */
 bool lpi_is_protocol_inactive(lpi_protocol_t proto);
+
+/** Returns the protocol with the given name.
+ *
+ * This is the reverse of lpi_print(). The comparison is case-insensitive.
+ * Names are looked up in a perfect hash that is built by 
+ * lpi_init_library(), so this is cheap enough to call for every flow.
+ *
+ * @param name The name of the protocol, as returned by lpi_print().
+ *
+ * @return The protocol with the given name, or LPI_PROTO_LAST if there is
+ * no active protocol with that name.
+ */
+lpi_protocol_t lpi_protocol_by_name(const char *name);
 #ifdef __cplusplus 
 }
 #endif
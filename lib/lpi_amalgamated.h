@@ -0,0 +1,51 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* The amalgamated classifier generated by gen_amalgamation.sh.
+ *
+ * This is not built as part of the library. Programs that want it should
+ * run 'make amalgamation' in the lib directory and compile the resulting
+ * lpi_amalgamated.cc in with their own sources. lpi_init_library() must
+ * still be called first.
+ */
+
+#ifndef LPI_AMALGAMATED_H_
+#define LPI_AMALGAMATED_H_
+
+#include "libprotoident.h"
+
+/* Same as lpi_guess_protocol(), with every module enabled. The modules 
+ * returned are copies of the ones registered by the library, so compare 
+ * the protocol rather than the pointer */
+lpi_module_t *lpi_amalgamated_guess(lpi_data_t *data);
+
+#endif
@@ -34,6 +34,137 @@
 #include "libprotoident.h"
 #include "proto_common.h"
 
+__thread lpi_features_t *lpi_guess_features = NULL;
+bool lpi_guess_features_used = false;
+
+static inline bool sig_len_ok(const lpi_signature_t *sig, uint32_t len) {
+	if (len < sig->min_len)
+		return false;
+	if (sig->max_len != 0 && len > sig->max_len)
+		return false;
+	return true;
+}
+
+static inline uint32_t sigset_hash(uint32_t value, uint32_t mult) {
+	return (value * mult) >> (32 - LPI_SIGSET_BITS);
+}
+
+/* Looks for a multiplier that gives every distinct value in the group its
+ * own slot, then fills in the slots */
+static bool build_sigset_group(lpi_sigset_t *set, lpi_sigset_group_t *grp,
+		uint32_t count) {
+
+	uint8_t seen[1 << LPI_SIGSET_BITS];
+	uint32_t mult = 0x9e3779b1;
+	uint32_t i, h, tries;
+	bool ok = false;
+
+	for (tries = 0; tries < 100000 && !ok; tries++) {
+		memset(seen, 0, sizeof(seen));
+		ok = true;
+		for (i = 0; i < count && ok; i++) {
+			const lpi_signature_t *sig = &set->sigs[i];
+
+			if (sig->mask != grp->mask)
+				continue;
+			h = sigset_hash(sig->value, mult);
+			if (seen[h] == 0)
+				seen[h] = i + 1;
+			else if (set->sigs[seen[h] - 1].value != sig->value)
+				ok = false;
+		}
+		if (!ok)
+			mult = (mult * 1664525 + 1013904223) | 1;
+	}
+
+	if (!ok)
+		return false;
+
+	grp->mult = mult;
+	memcpy(grp->slot, seen, sizeof(seen));
+	return true;
+}
+
+/* Marks every first byte that the signature could match */
+static void add_sigset_first(lpi_sigset_t *set, const lpi_signature_t *sig) {
+
+	uint8_t mask = ((const uint8_t *)&sig->mask)[0];
+	uint8_t value = ((const uint8_t *)&sig->value)[0];
+	uint32_t b;
+
+	for (b = 0; b < 256; b++) {
+		if ((b & mask) == value)
+			set->first[b >> 5] |= (1U << (b & 31));
+	}
+}
+
+static uint32_t build_sigset(lpi_sigset_t *set) {
+
+	uint32_t count, i, j, g;
+
+	for (count = 0; set->sigs[count].mask != 0; count++) {
+		if (count == LPI_SIGSET_MAX_SIGS)
+			return LPI_SIGSET_LINEAR;
+	}
+
+	memset(set->next, 0, sizeof(set->next));
+	memset(set->first, 0, sizeof(set->first));
+	set->groups = 0;
+
+	for (i = 0; i < count; i++) {
+		const lpi_signature_t *sig = &set->sigs[i];
+
+		for (g = 0; g < set->groups; g++) {
+			if (set->group[g].mask == sig->mask)
+				break;
+		}
+		if (g == set->groups) {
+			if (g == LPI_SIGSET_MAX_MASKS)
+				return LPI_SIGSET_LINEAR;
+			set->group[g].mask = sig->mask;
+			set->groups ++;
+		}
+		add_sigset_first(set, sig);
+
+		/* Chain signatures that only differ in their length bounds
+		 * onto the first one with the same value */
+		for (j = i + 1; j < count; j++) {
+			if (set->sigs[j].mask == sig->mask && 
+					set->sigs[j].value == sig->value) {
+				set->next[i] = j + 1;
+				break;
+			}
+		}
+	}
+
+	for (g = 0; g < set->groups; g++) {
+		if (!build_sigset_group(set, &set->group[g], count))
+			return LPI_SIGSET_LINEAR;
+	}
+	return LPI_SIGSET_READY;
+}
+
+bool match_sigset_slow(lpi_sigset_t *set, uint32_t payload, uint32_t len) {
+
+	const lpi_signature_t *sig;
+	uint32_t expected = LPI_SIGSET_UNBUILT;
+
+	/* Only one thread builds the tables -- anyone else who comes along 
+	 * in the meantime tries the signatures in order */
+	if (__atomic_compare_exchange_n(&set->state, &expected, 
+			LPI_SIGSET_BUILDING, false, __ATOMIC_ACQUIRE, 
+			__ATOMIC_RELAXED)) {
+		__atomic_store_n(&set->state, build_sigset(set), 
+				__ATOMIC_RELEASE);
+	}
+
+	for (sig = set->sigs; sig->mask != 0; sig++) {
+		if ((payload & sig->mask) == sig->value && sig_len_ok(sig, len))
+			return true;
+	}
+	return false;
+}
+
 bool match_str_either(lpi_data_t *data, const char *string) {
 
         if (MATCHSTR(data->payload[0], string))
@@ -82,6 +213,49 @@ bool match_payload_length(uint32_t payload, uint32_t payload_len) {
         return false;
 }
 
+/* Returns true if the first payload in the given direction is a single 
+ * line of printable text, ending with CRLF. This needs extended payload
+ * capture, so it will always return false without it */
+bool match_text_line(lpi_data_t *data, uint8_t dir) {
+
+	const uint8_t *bytes;
+	uint32_t len, i;
+
+	len = lpi_get_payload_prefix(data, dir, &bytes);
+	if (len <= 4)
+		return false;
+
+	for (i = 0; i < len - 1; i++) {
+		if (bytes[i] == '\r')
+			return (i > 0 && bytes[i + 1] == '\n');
+		if (bytes[i] < 0x20 || bytes[i] > 0x7e)
+			return false;
+	}
+	return false;
+}
+
+/* Returns true if the payload is an IPv4 address belonging to one of the
+ * endpoints. For IPv6 flows, ips only holds the last four bytes of each 
+ * address so we also check for the IPv4 address embedded in a 6to4 
+ * (2002::/16) address if the full addresses are available */
+static inline bool match_endpoint_ip(lpi_data_t *data, uint32_t payload) {
+
+	if (payload == data->ips[0] || payload == data->ips[1])
+		return true;
+
+	if (data->ip_version != 6 || data->ip6 == NULL)
+		return false;
+
+	for (int i = 0; i < 2; i++) {
+		const uint8_t *addr = data->ip6->addr[i];
+
+		if (addr[0] == 0x20 && addr[1] == 0x02 && 
+				memcmp(&payload, addr + 2, 4) == 0)
+			return true;
+	}
+	return false;
+}
+
 bool match_ip_address_both(lpi_data_t *data) {
 
 	uint8_t matches = 0;
@@ -91,16 +265,12 @@ bool match_ip_address_both(lpi_data_t *data) {
 	
 	if (data->payload_len[0] == 0)
 		matches += 1;
-	else if (data->payload[0] == data->ips[0])
-		matches += 1;
-	else if (data->payload[0] == data->ips[1])
+	else if (match_endpoint_ip(data, data->payload[0]))
 		matches += 1;
 		
 	if (data->payload_len[1] == 0)
 		matches += 1;
-	else if (data->payload[1] == data->ips[0])
-		matches += 1;
-	else if (data->payload[1] == data->ips[1])
+	else if (match_endpoint_ip(data, data->payload[1]))
 		matches += 1;
 	 
 	if (matches == 2)
@@ -111,198 +281,181 @@ bool match_ip_address_both(lpi_data_t *data) {
 }
 
 /* Multiple protocols use HTTP-style requests */
+static const lpi_signature_t http_request_sigs[] = {
+	LPI_SIG('G', 'E', 'T', ' '),
+	LPI_SIG_LEN('G', 0x00, 0x00, 0x00, 1, 1),
+	LPI_SIG_LEN('G', 'E', 0x00, 0x00, 2, 2),
+	LPI_SIG_LEN('G', 'E', 'T', 0x00, 3, 3),
+
+	/* Some of these are MS-specific extensions */
+	LPI_SIG('P', 'O', 'S', 'T'),
+	LPI_SIG('H', 'E', 'A', 'D'),
+	LPI_SIG('P', 'U', 'T', ' '),
+	LPI_SIG('D', 'E', 'L', 'E'),
+	LPI_SIG('a', 'u', 't', 'h'),
+
+	/* SVN? */
+	LPI_SIG('R', 'E', 'P', 'O'),
+
+	/* Webdav */
+	LPI_SIG('L', 'O', 'C', 'K'),
+	LPI_SIG('U', 'N', 'L', 'O'),
+	LPI_SIG('O', 'P', 'T', 'I'),
+	LPI_SIG('P', 'R', 'O', 'P'),
+	LPI_SIG('M', 'K', 'C', 'O'),
+	LPI_SIG('P', 'O', 'L', 'L'),
+	LPI_SIG('S', 'E', 'A', 'R'),
+
+	/* Ntrip - some differential GPS system using modified HTTP */
+	LPI_SIG('S', 'O', 'U', 'R'),
+	LPI_SIG_END
+};
+
+static lpi_sigset_t http_request_set = LPI_SIGSET(http_request_sigs);
+
 bool match_http_request(uint32_t payload, uint32_t len) {
 
-        /* HTTP requests - some of these are MS-specific extensions */
         if (len == 0)
                 return true;
 
-        if (MATCHSTR(payload, "GET ")) return true;
-        if (len == 1 && MATCH(payload, 'G', 0x00, 0x00, 0x00))
+	return match_sigset(&http_request_set, payload, len);
+}
+
+bool match_http_response(uint32_t payload, uint32_t len) {
+
+        if (len == 0)
                 return true;
-        if (len == 2 && MATCH(payload, 'G', 'E', 0x00, 0x00))
+        if (len == 1 && MATCH(payload, 'H', 0x00, 0x00, 0x00))
                 return true;
-        if (len == 3 && MATCH(payload, 'G', 'E', 'T', 0x00))
+        if (MATCHSTR(payload, "HTTP")) {
                 return true;
+        }
 
-        if (MATCHSTR(payload, "POST")) return true;
-        if (MATCHSTR(payload, "HEAD")) return true;
-        if (MATCHSTR(payload, "PUT ")) return true;
-        if (MATCHSTR(payload, "DELE")) return true;
-        if (MATCHSTR(payload, "auth")) return true;
-
-        /* SVN? */
-        if (MATCHSTR(payload, "REPO")) return true;
-
-        /* Webdav */
-        if (MATCHSTR(payload, "LOCK")) return true;
-        if (MATCHSTR(payload, "UNLO")) return true;
-        if (MATCHSTR(payload, "OPTI")) return true;
-        if (MATCHSTR(payload, "PROP")) return true;
-        if (MATCHSTR(payload, "MKCO")) return true;
-        if (MATCHSTR(payload, "POLL")) return true;
-        if (MATCHSTR(payload, "SEAR")) return true;
-
-        /* Ntrip - some differential GPS system using modified HTTP */
-        if (MATCHSTR(payload, "SOUR")) return true;
-
+        /* UNKNOWN seems to be a valid response from some servers, e.g.
+         * mini_httpd */
+        if (MATCHSTR(payload, "UNKN")) {
+                return true;
+        }
 
         return false;
-
 }
 
 /* File headers are not specific to any particular protocol */
-bool match_file_header(uint32_t payload) {
+static const lpi_signature_t file_header_sigs[] = {
+	/* RIFF is a meta-format for storing AVI and WAV files */
+	LPI_SIG('R', 'I', 'F', 'F'),
 
-        /* RIFF is a meta-format for storing AVI and WAV files */
-        if (MATCHSTR(payload, "RIFF"))
-                return true;
+	/* MZ is a .exe file */
+	LPI_SIG('M', 'Z', ANY, 0x00),
 
-        /* MZ is a .exe file */
-        if (MATCH(payload, 'M', 'Z', ANY, 0x00))
-                return true;
+	/* Ogg files */
+	LPI_SIG('O', 'g', 'g', 'S'),
 
-        /* Ogg files */
-        if (MATCHSTR(payload, "OggS"))
-                return true;
+	/* ZIP files */
+	LPI_SIG('P', 'K', 0x03, 0x04),
 
-        /* ZIP files */
-        if (MATCH(payload, 'P', 'K', 0x03, 0x04))
-                return true;
+	/* MPEG files */
+	LPI_SIG(0x00, 0x00, 0x01, 0xba),
 
-        /* MPEG files */
-        if (MATCH(payload, 0x00, 0x00, 0x01, 0xba))
-                return true;
+	/* RAR files */
+	LPI_SIG('R', 'a', 'r', '!'),
 
-        /* RAR files */
-        if (MATCHSTR(payload, "Rar!"))
-                return true;
+	/* EBML */
+	LPI_SIG(0x1a, 0x45, 0xdf, 0xa3),
 
-        /* EBML */
-        if (MATCH(payload, 0x1a, 0x45, 0xdf, 0xa3))
-                return true;
+	/* JPG */
+	LPI_SIG(0xff, 0xd8, ANY, ANY),
 
-        /* JPG */
-        if (MATCH(payload, 0xff, 0xd8, ANY, ANY))
-                return true;
+	/* GIF */
+	LPI_SIG('G', 'I', 'F', '8'),
 
-        /* GIF */
-        if (MATCHSTR(payload, "GIF8"))
-                return true;
+	/* I'm also going to include PHP scripts in here */
+	LPI_SIG(0x3c, 0x3f, 0x70, 0x68),
 
-        /* I'm also going to include PHP scripts in here */
-        if (MATCH(payload, 0x3c, 0x3f, 0x70, 0x68))
-                return true;
+	/* Unix scripts */
+	LPI_SIG(0x23, 0x21, 0x2f, 0x62),
 
-        /* Unix scripts */
-        if (MATCH(payload, 0x23, 0x21, 0x2f, 0x62))
-                return true;
+	/* PDFs */
+	LPI_SIG('%', 'P', 'D', 'F'),
 
-        /* PDFs */
-        if (MATCHSTR(payload, "%PDF"))
-                return true;
+	/* PNG */
+	LPI_SIG(0x89, 'P', 'N', 'G'),
 
-        /* PNG */
-        if (MATCH(payload, 0x89, 'P', 'N', 'G'))
-                return true;
+	/* HTML */
+	LPI_SIG('<', 'h', 't', 'm'),
+	LPI_SIG(0x0a, '<', '!', 'D'),
 
-        /* HTML */
-        if (MATCHSTR(payload, "<htm"))
-                return true;
-        if (MATCH(payload, 0x0a, '<', '!', 'D'))
-                return true;
+	/* 7zip */
+	LPI_SIG(0x37, 0x7a, 0xbc, 0xaf),
 
-        /* 7zip */
-        if (MATCH(payload, 0x37, 0x7a, 0xbc, 0xaf))
-                return true;
+	/* gzip  - may need to replace last two bytes with ANY */
+	LPI_SIG(0x1f, 0x8b, 0x08, ANY),
 
-        /* gzip  - may need to replace last two bytes with ANY */
-        if (MATCH(payload, 0x1f, 0x8b, 0x08, ANY))
-                return true;
+	/* XML */
+	LPI_SIG('<', '!', 'D', 'O'),
 
-        /* XML */
-        if (MATCHSTR(payload, "<!DO"))
-                return true;
+	/* FLAC */
+	LPI_SIG('f', 'L', 'a', 'C'),
 
-        /* FLAC */
-        if (MATCHSTR(payload, "fLaC"))
-                return true;
+	/* MP3 */
+	LPI_SIG('I', 'D', '3', 0x03),
+	LPI_SIG(0xff, 0xfb, 0x90, 0xc0),
 
-        /* MP3 */
-        if (MATCH(payload, 'I', 'D', '3', 0x03))
-                return true;
-	if (MATCHSTR(payload, "\xff\xfb\x90\xc0"))
-		return true;
+	/* RPM */
+	LPI_SIG(0xed, 0xab, 0xee, 0xdb),
 
-        /* RPM */
-        if (MATCH(payload, 0xed, 0xab, 0xee, 0xdb))
-                return true;
+	/* Wz Patch */
+	LPI_SIG('W', 'z', 'P', 'a'),
 
-        /* Wz Patch */
-        if (MATCHSTR(payload, "WzPa"))
-                return true;
+	/* Flash Video */
+	LPI_SIG('F', 'L', 'V', 0x01),
 
-        /* Flash Video */
-        if (MATCH(payload, 'F', 'L', 'V', 0x01))
-                return true;
+	/* .BKF (Microsoft Tape Format) */
+	LPI_SIG('T', 'A', 'P', 'E'),
 
-        /* .BKF (Microsoft Tape Format) */
-        if (MATCHSTR(payload, "TAPE"))
-                return true;
+	/* MS Office Doc file - this is unpleasantly geeky */
+	LPI_SIG(0xd0, 0xcf, 0x11, 0xe0),
 
-        /* MS Office Doc file - this is unpleasantly geeky */
-        if (MATCH(payload, 0xd0, 0xcf, 0x11, 0xe0))
-                return true;
+	/* ASP */
+	LPI_SIG(0x3c, 0x25, 0x40, 0x20),
 
-        /* ASP */
-        if (MATCH(payload, 0x3c, 0x25, 0x40, 0x20))
-                return true;
-
-        /* WMS file */
-        if (MATCH(payload, 0x3c, 0x21, 0x2d, 0x2d))
-                return true;
+	/* WMS file */
+	LPI_SIG(0x3c, 0x21, 0x2d, 0x2d),
 
 	/* ar archive, typically .deb files */
-	if (MATCHSTR(payload, "!<ar"))
-		return true;
+	LPI_SIG('!', '<', 'a', 'r'),
 
 	/* Raw XML */
-	if (MATCHSTR(payload, "<?xm"))
-		return true;
-	if (MATCHSTR(payload, "<iq "))
-		return true;
+	LPI_SIG('<', '?', 'x', 'm'),
+	LPI_SIG('<', 'i', 'q', ' '),
 
 	/* SPF */
-	if (MATCHSTR(payload, "SPFI"))
-		return true;
+	LPI_SIG('S', 'P', 'F', 'I'),
 
 	/* ABIF - Applied Biosystems */
-	if (MATCHSTR(payload, "ABIF"))
-		return true;
+	LPI_SIG('A', 'B', 'I', 'F'),
 
 	/* bzip2 - other digits are also possible instead of 9 */
-	if (MATCH(payload, 'B', 'Z', 'h', '9'))
-		return true;
+	LPI_SIG('B', 'Z', 'h', '9'),
 
-        /* I'm pretty sure the following are files of some type or another.
-         * They crop up pretty often in our test data sets, so I'm going to
-         * put them in here.
-         *
-         * Hopefully one day we will find out what they really are */
+	/* I'm pretty sure the following are files of some type or another.
+	 * They crop up pretty often in our test data sets, so I'm going to
+	 * put them in here.
+	 *
+	 * Hopefully one day we will find out what they really are */
+	LPI_SIG('<', 'c', 'f', ANY),
+	LPI_SIG('<', 'C', 'F', ANY),
+	LPI_SIG('.', 't', 'e', 'm'),
+	LPI_SIG('.', 'i', 't', 'e'),
+	LPI_SIG('.', 'l', 'e', 'f'),
+	LPI_SIG_END
+};
 
-        if (MATCH(payload, '<', 'c', 'f', ANY))
-                return true;
-        if (MATCH(payload, '<', 'C', 'F', ANY))
-                return true;
-        if (MATCHSTR(payload, ".tem"))
-                return true;
-        if (MATCHSTR(payload, ".ite"))
-                return true;
-        if (MATCHSTR(payload, ".lef"))
-                return true;
+static lpi_sigset_t file_header_set = LPI_SIGSET(file_header_sigs);
 
-        return false;
+bool match_file_header(uint32_t payload) {
 
+	return match_sigset(&file_header_set, payload, 0);
 }
 
 bool valid_http_port(lpi_data_t *data) {
@@ -393,7 +546,7 @@ static inline bool match_tls_content(uint32_t payload, uint32_t len) {
         return false;
 }
 
-bool match_ssl(lpi_data_t *data) {
+static bool check_ssl(lpi_data_t *data) {
 
 
         if (match_ssl3_handshake(data->payload[0], data->payload_len[0]) &&
@@ -476,15 +629,13 @@ static bool dns_req(uint32_t payload) {
          * Remember BYTE ORDER!
          */
 
-	payload = htonl(payload);
-
-	if ((payload & 0x0000ffff) == 0x00000000)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00000000))
 		return true;
 	/* Check for CD */
-	if ((payload & 0x0000ffff) == 0x00000010)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00000010))
 		return true;
 	/* Check for RD */
-	if ((payload & 0x0000ffff) == 0x00000100)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00000100))
 		return true;
 
 
@@ -498,25 +649,23 @@ static bool dns_backscatter(uint32_t payload) {
 
 	/* Last byte seems to be always 0x00 - third is either 0x84 or 0x85 */
 
-	payload = htonl(payload);
-
-	if ((payload & 0x0000ffff) == 0x00008500)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008500))
 		return true;
-	if ((payload & 0x0000ffff) == 0x00008400)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008400))
 		return true;
-	if ((payload & 0x0000ffff) == 0x00008480)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008480))
 		return true;
-	if ((payload & 0x0000ffff) == 0x00008483)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008483))
 		return true;
-	if ((payload & 0x0000ffff) == 0x00008403)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008403))
 		return true;
-	if ((payload & 0x0000ffff) == 0x00008000)
+	if (MATCHBITS(payload, 0x0000ffff, 0x00008000))
 		return true;
 
 	return false;
 }
 
-bool match_dns(lpi_data_t *data) {
+static bool check_dns(lpi_data_t *data) {
 
         if (data->payload_len[0] == 0 || data->payload_len[1] == 0) {
 
@@ -540,23 +689,95 @@ bool match_dns(lpi_data_t *data) {
                 return false;
         }
 
-        if (((htonl(data->payload[0])) & 0xffff7800) != 
-			((htonl(data->payload[1])) & 0xffff7800))
+        if (!SAMEBITS(data->payload[0], data->payload[1], 0xffff7800))
                 return false;
 
-        if ((htonl(data->payload[0]) & 0x00008000) == 
-		(htonl(data->payload[1]) & 0x00008000))
+        if (SAMEBITS(data->payload[0], data->payload[1], 0x00008000))
                 return false;
 
         return true;
 
 }
 
+/* Returns true if the flow has the given feature, using 'check' to work it
+ * out. If the flow is currently being guessed, the answer is remembered so
+ * that the next module to ask for the same feature doesn't have to work it
+ * out again */
+static inline bool has_feature(lpi_data_t *data, uint32_t feature,
+		bool (*check)(lpi_data_t *)) {
+
+	lpi_features_t *feat;
+
+	if (!__atomic_load_n(&lpi_guess_features_used, __ATOMIC_RELAXED))
+		return check(data);
+
+	feat = lpi_guess_features;
+	if (feat == NULL || feat->data != data)
+		return check(data);
+
+	if (!(feat->known & feature)) {
+		feat->known |= feature;
+		if (check(data))
+			feat->present |= feature;
+	}
+	return (feat->present & feature) != 0;
+}
+
+/* Same as has_feature(), but for a feature of the payload in one 
+ * direction */
+static inline bool has_dir_feature(lpi_data_t *data, uint8_t dir, 
+		uint32_t feature, bool (*check)(uint32_t, uint32_t)) {
+
+	lpi_features_t *feat;
+
+	if (!__atomic_load_n(&lpi_guess_features_used, __ATOMIC_RELAXED))
+		return check(data->payload[dir], data->payload_len[dir]);
+
+	feature <<= dir;
+	feat = lpi_guess_features;
+	if (feat == NULL || feat->data != data)
+		return check(data->payload[dir], data->payload_len[dir]);
+
+	if (!(feat->known & feature)) {
+		feat->known |= feature;
+		if (check(data->payload[dir], data->payload_len[dir]))
+			feat->present |= feature;
+	}
+	return (feat->present & feature) != 0;
+}
+
+static bool check_file_header(uint32_t payload, uint32_t len) {
+	return match_file_header(payload);
+}
+
+bool match_ssl(lpi_data_t *data) {
+	return has_feature(data, LPI_FEATURE_SSL, check_ssl);
+}
+
+bool match_dns(lpi_data_t *data) {
+	return has_feature(data, LPI_FEATURE_DNS, check_dns);
+}
+
+bool has_http_request(lpi_data_t *data, uint8_t dir) {
+	return has_dir_feature(data, dir, LPI_FEATURE_HTTP_REQUEST, 
+			match_http_request);
+}
+
+bool has_http_response(lpi_data_t *data, uint8_t dir) {
+	return has_dir_feature(data, dir, LPI_FEATURE_HTTP_RESPONSE, 
+			match_http_response);
+}
+
+bool has_file_header(lpi_data_t *data, uint8_t dir) {
+	return has_dir_feature(data, dir, LPI_FEATURE_FILE_HEADER, 
+			check_file_header);
+}
+
 bool match_tds_request(uint32_t payload, uint32_t len) {
 
         uint32_t stated_len = 0;
 
-        stated_len = (ntohl(payload) & 0xffff);
+        stated_len = PAYLOAD_FIELD16(payload, 2);
         if (stated_len != len)
                 return false;
 
@@ -675,7 +896,7 @@ bool match_tpkt(uint32_t payload, uint32_t len) {
         if (!MATCH(payload, 0x03, 0x00, ANY, ANY))
                 return false;
 
-        stated_len = ntohl(payload) & 0xffff;
+        stated_len = PAYLOAD_FIELD16(payload, 2);
         if (stated_len != len)
                 return false;
         return true;
@@ -55,9 +55,135 @@
 #define MATCH(x,a,b,c,d) \
                 ((x&FORMUPMASK(a,b,c,d))==(FORMUP(a,b,c,d)&FORMUPMASK(a,b,c,d)))
 
+/* Tests bits of a payload word against a mask and value written the way
+ * they would look after ntohl(), e.g. MATCHBITS(x, 0x0000ff00, 0x00000200)
+ * is true if the third byte is 0x02. As with MATCH(), the constants are
+ * put into network byte order at compile time, so the payload itself never
+ * needs to be byte swapped */
+#define NETWORD(v) \
+	FORMUP((v) >> 24, (v) >> 16, (v) >> 8, (v))
+#define MATCHBITS(x,mask,value) \
+	(((x) & NETWORD(mask)) == NETWORD(value))
+#define SAMEBITS(x,y,mask) \
+	((((x) ^ (y)) & NETWORD(mask)) == 0)
+
+/* Numeric fields within a payload word -- the nth byte, and the big-endian
+ * 16 bit value that starts at the nth byte */
+#if BYTE_ORDER == BIG_ENDIAN
+#define PAYLOAD_BYTE(x,n) \
+	((uint8_t)((x) >> (24 - 8 * (n))))
+#else
+#define PAYLOAD_BYTE(x,n) \
+	((uint8_t)((x) >> (8 * (n))))
+#endif
+#define PAYLOAD_FIELD16(x,n) \
+	((uint16_t)(ntohl(x) >> (16 - 8 * (n))))
+
 #define MATCHSTR(x,st) \
         (memcmp(&(x),(st),sizeof(x))==0)
 
+/* Macros for declaring the payload signatures for a module. Octets can be
+ * ANY, in the same way as MATCH() */
+#define LPI_SIG(a,b,c,d) \
+	LPI_SIG_LEN(a,b,c,d,0,0)
+#define LPI_SIG_LEN(a,b,c,d,min,max) \
+	{ FORMUP(a,b,c,d) & FORMUPMASK(a,b,c,d), FORMUPMASK(a,b,c,d), \
+		(min), (max) }
+#define LPI_SIG_END \
+	{ 0, 0, 0, 0 }
+
+/* Macros for declaring the payload length lists for a module */
+#define LPI_LEN(n) \
+	{ (n), (n) }
+#define LPI_LEN_RANGE(min,max) \
+	{ (min), (max) }
+#define LPI_LEN_MIN(min) \
+	{ (min), 0xffffffffU }
+#define LPI_LEN_END \
+	{ 1, 0 }
+
+/* A set of signatures, declared using the macros above, that can be 
+ * tested against a payload in constant time no matter how many 
+ * alternatives the set contains. Use this in place of long chains of 
+ * MATCH() / MATCHSTR() tests.
+ *
+ * Payloads are first checked against a bitmap of the first bytes that any
+ * of the signatures could match, which rules out most of them. After that,
+ * the signatures are grouped by mask and each group gets a collision-free
+ * multiplicative hash of the masked payload, so a test costs one probe per
+ * distinct mask (at most LPI_SIGSET_MAX_MASKS). The tables are built the 
+ * first time the set is used; until they are ready, or if the set is too 
+ * big to hash, the signatures are simply tried in order.
+ */
+#define LPI_SIGSET_MAX_MASKS 4
+#define LPI_SIGSET_MAX_SIGS 64
+#define LPI_SIGSET_BITS 8
+
+enum {
+	LPI_SIGSET_UNBUILT,
+	LPI_SIGSET_BUILDING,
+	LPI_SIGSET_READY,
+	LPI_SIGSET_LINEAR	/* Couldn't be hashed, so always try in order */
+};
+
+typedef struct lpi_sigset_group {
+	uint32_t mask;
+	uint32_t mult;			/* Hash multiplier */
+	uint8_t slot[1 << LPI_SIGSET_BITS];	/* Signature index + 1 */
+} lpi_sigset_group_t;
+
+typedef struct lpi_sigset {
+	const lpi_signature_t *sigs;	/* Terminated by LPI_SIG_END */
+	uint32_t state;			/* LPI_SIGSET_* */
+	uint32_t groups;
+	uint32_t first[256 / 32];	/* First bytes that could match */
+	/* Next signature (+ 1) with the same mask and value, but different
+	 * length bounds */
+	uint8_t next[LPI_SIGSET_MAX_SIGS];
+	lpi_sigset_group_t group[LPI_SIGSET_MAX_MASKS];
+} lpi_sigset_t;
+
+#define LPI_SIGSET(sigs) \
+	{ (sigs), LPI_SIGSET_UNBUILT, 0, { 0 }, { 0 }, { { 0, 0, { 0 } } } }
+
+/* Builds the tables for the set if nobody has yet, and tests the payload 
+ * against each signature in turn */
+bool match_sigset_slow(lpi_sigset_t *set, uint32_t payload, uint32_t len);
+
+/* Returns true if the payload matches any of the signatures in the set, 
+ * i.e. the same as testing each one with MATCH() and checking the length
+ * bounds */
+static inline bool match_sigset(lpi_sigset_t *set, uint32_t payload, 
+		uint32_t len) {
+
+	uint8_t b = ((uint8_t *)&payload)[0];
+	uint32_t g, idx, value;
+
+	if (__atomic_load_n(&set->state, __ATOMIC_ACQUIRE) != 
+			LPI_SIGSET_READY)
+		return match_sigset_slow(set, payload, len);
+
+	if (!(set->first[b >> 5] & (1U << (b & 31))))
+		return false;
+
+	for (g = 0; g < set->groups; g++) {
+		const lpi_sigset_group_t *grp = &set->group[g];
+		const lpi_signature_t *sig;
+
+		value = payload & grp->mask;
+		idx = grp->slot[(value * grp->mult) >> (32 - LPI_SIGSET_BITS)];
+
+		for (; idx != 0; idx = set->next[idx - 1]) {
+			sig = &set->sigs[idx - 1];
+			if (sig->value != value)
+				break;
+			if (len >= sig->min_len && (sig->max_len == 0 || 
+					len <= sig->max_len))
+				return true;
+		}
+	}
+	return false;
+}
 
 bool match_str_either(lpi_data_t *data, const char *string);
 bool match_str_both(lpi_data_t *data, const char *string1,
@@ -66,8 +192,10 @@ bool match_chars_either(lpi_data_t *data, char a, char b, char c,
         char d);
 bool match_payload_length(uint32_t payload, uint32_t payload_len);
 bool match_ip_address_both(lpi_data_t *data);
+bool match_text_line(lpi_data_t *data, uint8_t dir);
 bool match_file_header(uint32_t payload);
 bool match_http_request(uint32_t payload, uint32_t len);
+bool match_http_response(uint32_t payload, uint32_t len);
 bool valid_http_port(lpi_data_t *data);
 bool match_ssl(lpi_data_t *data);
 bool match_dns(lpi_data_t *data);
@@ -77,4 +205,66 @@ bool match_youku_payload(uint32_t payload, uint32_t len);
 bool match_emule(lpi_data_t *data);
 bool match_kaspersky(lpi_data_t *data);
 bool match_tpkt(uint32_t payload, uint32_t len);
+
+/* Features of a flow that several modules test for, i.e. the results of 
+ * match_ssl(), match_dns() and the HTTP / file header helpers. While a flow
+ * is being guessed by the batch or amalgamated classifiers, each feature 
+ * is only worked out the first time a module asks for it and the answer is
+ * kept in the flow's lpi_features_t until the guess is over. The 
+ * per-direction features are shifted left by the direction.
+ *
+ * The normal dispatch path doesn't bother: the port and signature tests 
+ * already stop all but one or two of the modules that use these helpers
+ * from being tried, so there is little to remember.
+ *
+ * Cheap tests like valid_http_port() and match_payload_length() are not 
+ * worth remembering -- looking up the answer costs about as much as 
+ * working it out again */
+#define LPI_FEATURE_SSL			0x0001
+#define LPI_FEATURE_DNS			0x0002
+#define LPI_FEATURE_HTTP_REQUEST	0x0010
+#define LPI_FEATURE_HTTP_RESPONSE	0x0040
+#define LPI_FEATURE_FILE_HEADER		0x0100
+
+typedef struct lpi_features {
+	const lpi_data_t *data;	/* The flow being guessed */
+	uint32_t known;		/* Features that have been worked out */
+	uint32_t present;	/* Features that the flow has */
+} lpi_features_t;
+
+/* The features for the flow that this thread is currently guessing, if 
+ * any. This uses the default TLS model rather than initial-exec, as the 
+ * library must still be loadable with dlopen() */
+extern __thread lpi_features_t *lpi_guess_features;
+
+/* In a shared library, every read of lpi_guess_features costs a call to 
+ * __tls_get_addr(). This is set the first time any thread publishes a 
+ * feature vector, so until then the helpers can skip the lookup */
+extern bool lpi_guess_features_used;
+
+static inline void use_guess_features(void) {
+	if (!__atomic_load_n(&lpi_guess_features_used, __ATOMIC_RELAXED))
+		__atomic_store_n(&lpi_guess_features_used, true, 
+				__ATOMIC_RELAXED);
+}
+
+static inline void begin_guess_features(lpi_features_t *feat, 
+		lpi_data_t *data) {
+	feat->data = data;
+	feat->known = 0;
+	feat->present = 0;
+	use_guess_features();
+	lpi_guess_features = feat;
+}
+
+static inline void end_guess_features(void) {
+	lpi_guess_features = NULL;
+}
+
+/* Same as match_http_request() etc, but for the payload in the given 
+ * direction and using the feature cache */
+bool has_http_request(lpi_data_t *data, uint8_t dir);
+bool has_http_response(lpi_data_t *data, uint8_t dir);
+bool has_file_header(lpi_data_t *data, uint8_t dir);
+
 #endif
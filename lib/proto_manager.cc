@@ -34,6 +34,9 @@
 
 #include <glob.h>
 #include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "proto_manager.h"
 #include "tcp/tcp_protocols.h"
@@ -71,6 +74,321 @@ void free_protocols(LPIModuleMap *mod_map) {
 	mod_map->clear();
 }
 
+/* Returns true if the module has a usable list of required ports */
+static bool has_required_ports(lpi_module_t *mod) {
+
+	if (mod->port_hint != LPI_PORTS_REQUIRED)
+		return false;
+	/* A module that claims to require ports but doesn't list any is
+	 * almost certainly a mistake -- be safe and always try it */
+	if (mod->ports == NULL || mod->ports[0] == 0)
+		return false;
+	return true;
+}
+
+static bool has_signatures(lpi_module_t *mod) {
+
+	if (mod->signatures == NULL || mod->signatures[0].mask == 0)
+		return false;
+	return true;
+}
+
+static bool has_lengths(lpi_module_t *mod) {
+
+	return (mod->lengths[0] != NULL || mod->lengths[1] != NULL);
+}
+
+/* Sets the module's bit in the given half of the length bitset pair for 
+ * every length bucket that the list accepts */
+static void add_length_list(LPIDispatchTable *table, uint64_t *pairs,
+		const lpi_length_range_t *range, uint32_t half, uint32_t i) {
+
+	uint32_t b, lo, hi;
+	uint32_t stride = 2 * table->words;
+	uint64_t *set = pairs + half * table->words + (i / 64);
+
+	if (range == NULL) {
+		for (b = 0; b < LPI_LEN_BUCKETS; b++)
+			set[b * stride] |= ((uint64_t)1 << (i % 64));
+		return;
+	}
+
+	for (; range->min_len <= range->max_len; range++) {
+		lo = length_bucket(range->min_len);
+		hi = length_bucket(range->max_len);
+		for (b = lo; b <= hi; b++)
+			set[b * stride] |= ((uint64_t)1 << (i % 64));
+	}
+}
+
+/* Builds the length index. The bitset pair for every bucket is worked out
+ * first, then buckets with identical pairs are merged */
+static int build_length_sets(LPIDispatchTable *table) {
+
+	uint32_t i, b, k, nsets = 0;
+	uint32_t stride = 2 * table->words;
+	uint64_t *pairs;
+
+	/* Leave the length test out of the table altogether if nobody needs
+	 * it */
+	for (i = 0; i < table->count; i++) {
+		if (has_lengths(table->entries[i].module))
+			break;
+	}
+	if (i == table->count)
+		return 0;
+
+	table->len_free = (uint64_t *)calloc(table->words, sizeof(uint64_t));
+	table->len_index = (uint16_t *)calloc(LPI_LEN_BUCKETS, 
+			sizeof(uint16_t));
+	pairs = (uint64_t *)calloc(LPI_LEN_BUCKETS * stride, 
+			sizeof(uint64_t));
+
+	if (table->len_free == NULL || table->len_index == NULL || 
+			pairs == NULL) {
+		if (pairs != NULL)
+			free(pairs);
+		fprintf(stderr, "Unable to allocate memory for length sets\n");
+		return -1;
+	}
+
+	for (i = 0; i < table->count; i++) {
+		lpi_module_t *mod = table->entries[i].module;
+
+		if (!has_lengths(mod)) {
+			table->len_free[i / 64] |= ((uint64_t)1 << (i % 64));
+			continue;
+		}
+		add_length_list(table, pairs, mod->lengths[0], 0, i);
+		add_length_list(table, pairs, mod->lengths[1], 1, i);
+	}
+
+	/* Any pair we keep is moved down to the next free slot, which is 
+	 * never after the bucket it came from */
+	for (b = 0; b < LPI_LEN_BUCKETS; b++) {
+		uint64_t *pair = pairs + b * stride;
+
+		for (k = 0; k < nsets; k++) {
+			if (memcmp(pairs + k * stride, pair, 
+					stride * sizeof(uint64_t)) == 0)
+				break;
+		}
+		if (k == nsets) {
+			memmove(pairs + k * stride, pair, 
+					stride * sizeof(uint64_t));
+			nsets ++;
+		}
+		table->len_index[b] = k;
+	}
+
+	table->len_sets = (uint64_t *)realloc(pairs, 
+			nsets * stride * sizeof(uint64_t));
+	if (table->len_sets == NULL) {
+		free(pairs);
+		fprintf(stderr, "Unable to allocate memory for length sets\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int build_candidate_sets(LPIDispatchTable *table) {
+
+	uint32_t i, b;
+	uint16_t nsets = 1;
+	const uint16_t *p;
+	const lpi_signature_t *sig;
+	const lpi_signature_t *scan_sigs[LPI_SIG_SCAN_MODULES];
+	uint32_t scanned = 0;
+
+	table->words = (table->count + 63) / 64;
+	table->port_index = (uint16_t *)calloc(65536, sizeof(uint16_t));
+	table->port_free = (uint64_t *)calloc(table->words, sizeof(uint64_t));
+	table->sig_free = (uint64_t *)calloc(table->words, sizeof(uint64_t));
+	table->prefix_sets = (uint64_t *)calloc(256 * table->words, 
+			sizeof(uint64_t));
+
+	if (table->port_index == NULL || table->port_free == NULL ||
+			table->sig_free == NULL || 
+			table->prefix_sets == NULL) {
+		fprintf(stderr, "Unable to allocate memory for candidate sets\n");
+		return -1;
+	}
+
+	/* First pass: work out which modules always need to be tried and
+	 * give each required port its own bitset */
+	for (i = 0; i < table->count; i++) {
+		lpi_module_t *mod = table->entries[i].module;
+
+		if (!has_required_ports(mod)) {
+			table->port_free[i / 64] |= ((uint64_t)1 << (i % 64));
+			continue;
+		}
+
+		for (p = mod->ports; *p != 0; p++) {
+			if (table->port_index[*p] != 0)
+				continue;
+			table->port_index[*p] = nsets;
+			nsets ++;
+		}
+	}
+
+	table->port_sets = (uint64_t *)calloc(nsets * table->words, 
+			sizeof(uint64_t));
+	if (table->port_sets == NULL) {
+		fprintf(stderr, "Unable to allocate memory for candidate sets\n");
+		return -1;
+	}
+
+	/* Second pass: populate the bitsets for each required port */
+	for (i = 0; i < table->count; i++) {
+		lpi_module_t *mod = table->entries[i].module;
+
+		if (!has_required_ports(mod))
+			continue;
+
+		for (p = mod->ports; *p != 0; p++) {
+			uint64_t *set = table->port_sets + 
+					table->port_index[*p] * table->words;
+			set[i / 64] |= ((uint64_t)1 << (i % 64));
+		}
+	}
+
+	/* Index the signatures by the first byte of payload. A signature
+	 * that doesn't care about some or all of the bits in the first byte
+	 * is added to the bitset for every byte value that it could match */
+	for (i = 0; i < table->count; i++) {
+		lpi_module_t *mod = table->entries[i].module;
+
+		if (!has_signatures(mod)) {
+			table->sig_free[i / 64] |= ((uint64_t)1 << (i % 64));
+			continue;
+		}
+
+		if (scanned < LPI_SIG_SCAN_MODULES) {
+			table->entries[i].sig_bit = ((uint64_t)1 << scanned);
+			scan_sigs[scanned] = mod->signatures;
+			scanned ++;
+		} else {
+			table->entries[i].sig_bit = LPI_SIG_UNSCANNED;
+		}
+
+		for (sig = mod->signatures; sig->mask != 0; sig++) {
+			uint8_t val = ((const uint8_t *)&sig->value)[0];
+			uint8_t mask = ((const uint8_t *)&sig->mask)[0];
+
+			for (b = 0; b < 256; b++) {
+				uint64_t *set;
+				
+				if ((b & mask) != (val & mask))
+					continue;
+				set = table->prefix_sets + b * table->words;
+				set[i / 64] |= ((uint64_t)1 << (i % 64));
+			}
+		}
+	}
+
+	if (build_length_sets(table) == -1)
+		return -1;
+	return build_sig_table(&table->sigs, scan_sigs, scanned);
+}
+
+/* Returns true if the module should be included in a dispatch table, given
+ * the array of enabled protocols (NULL means everything is enabled) */
+static inline bool module_enabled(lpi_module_t *mod, const bool *enabled) {
+
+	if (enabled == NULL)
+		return true;
+	return enabled[mod->protocol];
+}
+
+int build_dispatch_table(LPIModuleMap *mod_map, LPIDispatchTable *table,
+		const bool *enabled) {
+
+	LPIModuleMap::iterator it;
+	LPIModuleList::iterator l_it;
+	uint32_t count = 0;
+	uint32_t i = 0;
+
+	free_dispatch_table(table);
+
+	for (it = mod_map->begin(); it != mod_map->end(); it ++) {
+		LPIModuleList *ml = it->second;
+
+		for (l_it = ml->begin(); l_it != ml->end(); l_it ++) {
+			if (module_enabled(*l_it, enabled))
+				count ++;
+		}
+	}
+
+	if (count == 0)
+		return 0;
+
+	table->entries = (LPIDispatchEntry *)malloc(
+			sizeof(LPIDispatchEntry) * count);
+	if (table->entries == NULL) {
+		fprintf(stderr, "Unable to allocate memory for dispatch table\n");
+		return -1;
+	}
+
+	/* The map is sorted by priority and each list preserves the order
+	 * in which the modules were registered, so walking them in order
+	 * gives us exactly the same first-match behaviour as before */
+	for (it = mod_map->begin(); it != mod_map->end(); it ++) {
+		LPIModuleList *ml = it->second;
+
+		for (l_it = ml->begin(); l_it != ml->end(); l_it ++) {
+			if (!module_enabled(*l_it, enabled))
+				continue;
+			table->entries[i].lpi_callback = (*l_it)->lpi_callback;
+			table->entries[i].module = *l_it;
+			table->entries[i].sig_bit = 0;
+			i ++;
+		}
+	}
+
+	table->count = count;
+
+	if (build_candidate_sets(table) == -1) {
+		free_dispatch_table(table);
+		return -1;
+	}
+	return 0;
+}
+
+void free_dispatch_table(LPIDispatchTable *table) {
+
+	if (table->entries != NULL)
+		free(table->entries);
+	if (table->port_free != NULL)
+		free(table->port_free);
+	if (table->port_sets != NULL)
+		free(table->port_sets);
+	if (table->port_index != NULL)
+		free(table->port_index);
+	if (table->sig_free != NULL)
+		free(table->sig_free);
+	if (table->prefix_sets != NULL)
+		free(table->prefix_sets);
+	free_sig_table(&table->sigs);
+	if (table->len_free != NULL)
+		free(table->len_free);
+	if (table->len_index != NULL)
+		free(table->len_index);
+	if (table->len_sets != NULL)
+		free(table->len_sets);
+	table->entries = NULL;
+	table->port_free = NULL;
+	table->port_sets = NULL;
+	table->port_index = NULL;
+	table->sig_free = NULL;
+	table->prefix_sets = NULL;
+	table->len_free = NULL;
+	table->len_index = NULL;
+	table->len_sets = NULL;
+	table->count = 0;
+	table->words = 0;
+}
+
 int register_tcp_protocols(LPIModuleMap *mod_map) {
 
 	register_afp(mod_map);
@@ -369,18 +687,18 @@ int register_udp_protocols(LPIModuleMap *mod_map) {
 	return 0;
 }
 
-static void register_list_names(LPIModuleList *ml, LPINameMap *names) {
+static void register_list_names(LPIModuleList *ml, const char **names) {
 	LPIModuleList::iterator it; 
 
 	for (it = ml->begin(); it != ml->end(); it ++) {
 		lpi_module_t *mod = *it;
 
-		(*names)[mod->protocol] = mod->name;
+		names[mod->protocol] = mod->name;
 	}
 
 }
 
-void register_names(LPIModuleMap *mods, LPINameMap *names) {
+void register_names(LPIModuleMap *mods, const char **names) {
 
 	LPIModuleMap::iterator it;
 
@@ -390,7 +708,7 @@ void register_names(LPIModuleMap *mods, LPINameMap *names) {
 
 }
 
-void init_other_protocols(LPINameMap *name_map) {
+void init_other_protocols(const char **names) {
 
 	lpi_icmp = new lpi_module_t;
 
@@ -399,7 +717,7 @@ void init_other_protocols(LPINameMap *name_map) {
 	lpi_icmp->name = "ICMP";
 	lpi_icmp->priority = 255;
 	lpi_icmp->lpi_callback = NULL;
-	(*name_map)[lpi_icmp->protocol] = lpi_icmp->name;
+	names[lpi_icmp->protocol] = lpi_icmp->name;
 
 	lpi_unknown_tcp = new lpi_module_t;
 
@@ -408,7 +726,7 @@ void init_other_protocols(LPINameMap *name_map) {
 	lpi_unknown_tcp->name = "Unknown_TCP";
 	lpi_unknown_tcp->priority = 255;
 	lpi_unknown_tcp->lpi_callback = NULL;
-	(*name_map)[lpi_unknown_tcp->protocol] = lpi_unknown_tcp->name;
+	names[lpi_unknown_tcp->protocol] = lpi_unknown_tcp->name;
 	
 	lpi_unknown_udp = new lpi_module_t;
 
@@ -417,7 +735,7 @@ void init_other_protocols(LPINameMap *name_map) {
 	lpi_unknown_udp->name = "Unknown_UDP";
 	lpi_unknown_udp->priority = 255;
 	lpi_unknown_udp->lpi_callback = NULL;
-	(*name_map)[lpi_unknown_udp->protocol] = lpi_unknown_udp->name;
+	names[lpi_unknown_udp->protocol] = lpi_unknown_udp->name;
 
 	lpi_unsupported = new lpi_module_t;
 
@@ -426,7 +744,7 @@ void init_other_protocols(LPINameMap *name_map) {
 	lpi_unsupported->name = "Unsupported";
 	lpi_unsupported->priority = 255;
 	lpi_unsupported->lpi_callback = NULL;
-	(*name_map)[lpi_unsupported->protocol] = lpi_unsupported->name;
+	names[lpi_unsupported->protocol] = lpi_unsupported->name;
 
 }
 
@@ -39,18 +39,96 @@
 #include <map>
 
 #include "libprotoident.h"
+#include "result_cache.h"
+#include "sig_scan.h"
 
 
 typedef std::list<lpi_module_t *> LPIModuleList;
 typedef std::map<uint8_t, LPIModuleList *> LPIModuleMap;
-typedef std::map<lpi_protocol_t, const char *> LPINameMap;
+
+/* A single entry in a dispatch table. The callback is copied out of the
+ * module so that walking the table does not have to touch the module
+ * structure itself until we actually get a match. 
+ *
+ * sig_bit is the module's bit in the result of scan_signatures(), or
+ * zero if the module has no signatures (see sig_scan.h) */
+typedef struct lpi_dispatch_entry {
+	bool (*lpi_callback) (lpi_data_t *proto_d, lpi_module_t *module);
+	lpi_module_t *module;
+	uint64_t sig_bit;
+} LPIDispatchEntry;
+
+/* The registered modules for a transport protocol, flattened into a single
+ * contiguous array in priority order. The LPIModuleMap is only used while
+ * modules are being registered -- this is what gets walked when we are
+ * trying to guess the protocol for a flow */
+typedef struct lpi_dispatch_table {
+	LPIDispatchEntry *entries;
+	uint32_t count;
+
+	/* Candidate bitsets, with one bit per entry in the table. Each 
+	 * bitset is 'words' 64-bit words long. A module is only tried if
+	 * it passes both the port and the payload prefix test.
+	 *
+	 * 'port_free' has a bit set for every module that must be tried
+	 * regardless of the ports used by the flow. 'port_sets' is an 
+	 * array of bitsets, one for each port that appears in the port list
+	 * of a module marked as LPI_PORTS_REQUIRED. 'port_index' maps a 
+	 * port number to its bitset in 'port_sets' -- bitset zero is always
+	 * empty and is used for every port that no module requires.
+	 *
+	 * 'sig_free' has a bit set for every module that has no payload 
+	 * signatures. 'prefix_sets' holds 256 bitsets, indexed by the first
+	 * byte of payload, for the modules that do have signatures.
+	 *
+	 * 'sigs' holds all of the signatures, so that a flow that passes the 
+	 * prefix test can be checked against the rest of them in one go.
+	 *
+	 * 'len_free' has a bit set for every module that has no payload 
+	 * length lists. 'len_index' maps a payload length (see length_bucket)
+	 * to a pair of bitsets in 'len_sets': the modules that accept that 
+	 * length in their first list, followed by the modules that accept it
+	 * in their second. Lengths that every module treats the same way 
+	 * share a pair. If no module has length lists, these are all NULL.
+	 */
+	uint32_t words;
+	uint64_t *port_free;
+	uint64_t *port_sets;
+	uint16_t *port_index;
+	uint64_t *sig_free;
+	uint64_t *prefix_sets;
+	LPISigTable sigs;
+	uint64_t *len_free;
+	uint16_t *len_index;
+	uint64_t *len_sets;
+} LPIDispatchTable;
+
+/* Payload lengths are indexed individually up to this many bytes. Anything
+ * longer shares the last entry in len_index */
+#define LPI_LEN_BUCKETS 2048
+
+static inline uint32_t length_bucket(uint32_t len) {
+	return (len < LPI_LEN_BUCKETS - 1) ? len : LPI_LEN_BUCKETS - 1;
+}
+
+/* A classifier context. Once created, the dispatch tables are never 
+ * modified so a context can be shared by any number of threads. The result
+ * cache, if there is one, is safe to update concurrently */
+struct lpi_context {
+	LPIDispatchTable tcp;
+	LPIDispatchTable udp;
+	LPIResultCache *cache;
+};
 
 void register_protocol(lpi_module_t *mod, LPIModuleMap *mod_map);
 int register_tcp_protocols(LPIModuleMap *mod_map);
 int register_udp_protocols(LPIModuleMap *mod_map);
-void register_names(LPIModuleMap *mod_map, LPINameMap *name_map);
-void init_other_protocols(LPINameMap *name_map);
+void register_names(LPIModuleMap *mod_map, const char **names);
+void init_other_protocols(const char **names);
 void free_protocols(LPIModuleMap *mod_map);
+int build_dispatch_table(LPIModuleMap *mod_map, LPIDispatchTable *table,
+		const bool *enabled);
+void free_dispatch_table(LPIDispatchTable *table);
 
 
 extern lpi_module_t *lpi_icmp;
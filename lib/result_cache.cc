@@ -0,0 +1,191 @@
+/*
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libprotoident.h"
+#include "proto_common.h"
+#include "result_cache.h"
+
+LPIResultCache *create_result_cache(uint32_t entries) {
+
+	LPIResultCache *cache;
+	uint32_t size = 1;
+
+	while (size < entries) {
+		if (size == 0x80000000) {
+			fprintf(stderr, "Result cache size %u is too large\n",
+					entries);
+			return NULL;
+		}
+		size <<= 1;
+	}
+
+	cache = (LPIResultCache *)calloc(1, sizeof(LPIResultCache));
+	if (cache == NULL) {
+		fprintf(stderr, "Unable to allocate memory for result cache\n");
+		return NULL;
+	}
+
+	cache->entries = (LPICacheEntry *)calloc(size, sizeof(LPICacheEntry));
+	if (cache->entries == NULL) {
+		fprintf(stderr, "Unable to allocate memory for result cache\n");
+		free(cache);
+		return NULL;
+	}
+	cache->size = size;
+	return cache;
+}
+
+void free_result_cache(LPIResultCache *cache) {
+
+	if (cache == NULL)
+		return;
+	free(cache->entries);
+	free(cache);
+}
+
+/* Forgets every cached result, e.g. because the set of modules being tried
+ * has changed. Must not be called while other threads are using the 
+ * cache */
+void clear_result_cache(LPIResultCache *cache) {
+
+	if (cache == NULL)
+		return;
+	memset(cache->entries, 0, cache->size * sizeof(LPICacheEntry));
+}
+
+bool make_cache_key(lpi_data_t *data, LPICacheKey *key) {
+
+	uint64_t h;
+
+	/* The result for this flow may depend on its IP addresses */
+	if (match_ip_address_both(data))
+		return false;
+
+	/* ... or on payload beyond the first four bytes */
+	if (data->ext_slot != 0)
+		return false;
+
+	key->key[0] = ((uint64_t)data->payload[1] << 32) | data->payload[0];
+	key->key[1] = ((uint64_t)data->payload_len[1] << 32) | 
+			data->payload_len[0];
+
+	/* The No_Payload rules only care whether anything has been observed,
+	 * not how much */
+	key->key[2] = ((uint64_t)(data->observed[1] != 0) << 41) |
+			((uint64_t)(data->observed[0] != 0) << 40) |
+			((uint64_t)data->trans_proto << 32) | 
+			((uint64_t)data->client_port << 16) |
+			data->server_port;
+
+	h = key->key[0] * 0x9E3779B97F4A7C15ULL;
+	h ^= (h >> 29) ^ key->key[1];
+	h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= (h >> 32) ^ key->key[2];
+	h *= 0x94D049BB133111EBULL;
+	key->hash = h ^ (h >> 31);
+	return true;
+}
+
+lpi_module_t *lookup_result_cache(LPIResultCache *cache, LPICacheKey *key) {
+
+	LPICacheEntry *e = &cache->entries[key->hash & (cache->size - 1)];
+	uint64_t seq, k0, k1, k2;
+	lpi_module_t *module;
+
+	seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+	if (seq & 1)
+		goto miss;
+
+	k0 = __atomic_load_n(&e->key[0], __ATOMIC_RELAXED);
+	k1 = __atomic_load_n(&e->key[1], __ATOMIC_RELAXED);
+	k2 = __atomic_load_n(&e->key[2], __ATOMIC_RELAXED);
+	module = __atomic_load_n(&e->module, __ATOMIC_RELAXED);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != seq)
+		goto miss;
+
+	if (module == NULL || k0 != key->key[0] || k1 != key->key[1] || 
+			k2 != key->key[2])
+		goto miss;
+
+	__atomic_fetch_add(&cache->hits, 1, __ATOMIC_RELAXED);
+	return module;
+
+miss:
+	__atomic_fetch_add(&cache->misses, 1, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+void insert_result_cache(LPIResultCache *cache, LPICacheKey *key, 
+		lpi_module_t *module) {
+
+	LPICacheEntry *e = &cache->entries[key->hash & (cache->size - 1)];
+	uint64_t seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+
+	/* Someone else is already updating this entry -- we'll just let 
+	 * them have it */
+	if (seq & 1)
+		return;
+	if (!__atomic_compare_exchange_n(&e->seq, &seq, seq + 1, false, 
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	__atomic_store_n(&e->key[0], key->key[0], __ATOMIC_RELAXED);
+	__atomic_store_n(&e->key[1], key->key[1], __ATOMIC_RELAXED);
+	__atomic_store_n(&e->key[2], key->key[2], __ATOMIC_RELAXED);
+	__atomic_store_n(&e->module, module, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void count_cache_bypass(LPIResultCache *cache) {
+
+	__atomic_fetch_add(&cache->bypassed, 1, __ATOMIC_RELAXED);
+}
+
+void get_result_cache_stats(LPIResultCache *cache, lpi_cache_stats_t *stats) {
+
+	memset(stats, 0, sizeof(lpi_cache_stats_t));
+	if (cache == NULL)
+		return;
+
+	stats->entries = cache->size;
+	stats->hits = __atomic_load_n(&cache->hits, __ATOMIC_RELAXED);
+	stats->misses = __atomic_load_n(&cache->misses, __ATOMIC_RELAXED);
+	stats->bypassed = __atomic_load_n(&cache->bypassed, __ATOMIC_RELAXED);
+}
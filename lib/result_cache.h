@@ -0,0 +1,96 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Cache of recent classification results.
+ *
+ * The result of lpi_guess_protocol() depends only on a handful of fields in
+ * the LPI data, and on a busy link a large number of flows (DNS, NTP, 
+ * scans, flows with no payload...) share exactly the same values for those
+ * fields. The cache is a direct-mapped table keyed on those fields, so a 
+ * flow that looks exactly like a recent flow can skip the modules entirely.
+ *
+ * The only rules that look at anything else are those that compare the
+ * payload against the IP addresses of the flow (see match_ip_address_both)
+ * and those that use extended payload capture. Flows that could match one
+ * of those rules are never looked up or added.
+ *
+ * Each entry is protected by its own sequence number, so any number of 
+ * threads can look up and insert results at the same time without locking:
+ * a writer that finds an entry being updated by another thread simply 
+ * doesn't insert, and a reader that sees an entry change underneath it
+ * treats it as a miss.
+ */
+
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+#include <stdint.h>
+
+#include "libprotoident.h"
+
+typedef struct lpi_cache_entry {
+	uint64_t seq;		/* Odd while the entry is being written */
+	uint64_t key[3];
+	lpi_module_t *module;
+} LPICacheEntry;
+
+typedef struct lpi_result_cache {
+	uint32_t size;		/* Always a power of two */
+	LPICacheEntry *entries;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t bypassed;
+} LPIResultCache;
+
+/* The fields of the LPI data that the rules depend on, packed into three
+ * words, along with the hash of those words */
+typedef struct lpi_cache_key {
+	uint64_t key[3];
+	uint64_t hash;
+} LPICacheKey;
+
+LPIResultCache *create_result_cache(uint32_t entries);
+void free_result_cache(LPIResultCache *cache);
+void clear_result_cache(LPIResultCache *cache);
+
+/* Fills in the key for the given flow. Returns false if the flow must not 
+ * use the cache, in which case the caller should count it using
+ * count_cache_bypass() */
+bool make_cache_key(lpi_data_t *data, LPICacheKey *key);
+void count_cache_bypass(LPIResultCache *cache);
+lpi_module_t *lookup_result_cache(LPIResultCache *cache, LPICacheKey *key);
+void insert_result_cache(LPIResultCache *cache, LPICacheKey *key, 
+		lpi_module_t *module);
+void get_result_cache_stats(LPIResultCache *cache, lpi_cache_stats_t *stats);
+
+#endif
@@ -0,0 +1,265 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+#define __STDC_LIMIT_MACROS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define LPI_SIG_SCAN_X86
+#endif
+
+#include "libprotoident.h"
+#include "sig_scan.h"
+
+/* Turns the lanes that matched in one step of a kernel into module bits */
+static inline uint64_t lanes_to_modules(const LPISigTable *table, 
+		uint32_t first, uint32_t lanes) {
+
+	uint64_t found = 0;
+
+	while (lanes != 0) {
+		found |= ((uint64_t)1 << table->module[first + 
+				__builtin_ctz(lanes)]);
+		lanes &= (lanes - 1);
+	}
+	return found;
+}
+
+static uint64_t scan_scalar(const LPISigTable *table, uint32_t payload0,
+		uint32_t len0, uint32_t payload1, uint32_t len1) {
+
+	uint64_t found = 0;
+	uint32_t i;
+
+	for (i = 0; i < table->count; i++) {
+		bool hit0 = (payload0 & table->mask[i]) == table->value[i] &&
+				len0 >= table->min_len[i] && 
+				len0 <= table->max_len[i];
+		bool hit1 = (payload1 & table->mask[i]) == table->value[i] &&
+				len1 >= table->min_len[i] && 
+				len1 <= table->max_len[i];
+
+		if (hit0 || hit1)
+			found |= ((uint64_t)1 << table->module[i]);
+	}
+	return found;
+}
+
+#ifdef LPI_SIG_SCAN_X86
+
+/* SSE4.1 is enough for the unsigned min / max used for the length tests, but
+ * every CPU that has it also has SSE4.2 and that is what people look for */
+__attribute__((target("sse4.2")))
+static uint64_t scan_sse42(const LPISigTable *table, uint32_t payload0,
+		uint32_t len0, uint32_t payload1, uint32_t len1) {
+
+	__m128i p0 = _mm_set1_epi32(payload0);
+	__m128i l0 = _mm_set1_epi32(len0);
+	__m128i p1 = _mm_set1_epi32(payload1);
+	__m128i l1 = _mm_set1_epi32(len1);
+	uint64_t found = 0;
+	uint32_t i;
+
+	for (i = 0; i < table->count; i += 4) {
+		__m128i value = _mm_load_si128((const __m128i *)
+				(table->value + i));
+		__m128i mask = _mm_load_si128((const __m128i *)
+				(table->mask + i));
+		__m128i minl = _mm_load_si128((const __m128i *)
+				(table->min_len + i));
+		__m128i maxl = _mm_load_si128((const __m128i *)
+				(table->max_len + i));
+		__m128i hit0, hit1;
+		int lanes;
+
+		/* min <= len is the same as max(len, min) == len, and
+		 * likewise for the upper bound */
+		hit0 = _mm_cmpeq_epi32(_mm_and_si128(p0, mask), value);
+		hit0 = _mm_and_si128(hit0, 
+				_mm_cmpeq_epi32(_mm_max_epu32(l0, minl), l0));
+		hit0 = _mm_and_si128(hit0,
+				_mm_cmpeq_epi32(_mm_min_epu32(l0, maxl), l0));
+
+		hit1 = _mm_cmpeq_epi32(_mm_and_si128(p1, mask), value);
+		hit1 = _mm_and_si128(hit1, 
+				_mm_cmpeq_epi32(_mm_max_epu32(l1, minl), l1));
+		hit1 = _mm_and_si128(hit1,
+				_mm_cmpeq_epi32(_mm_min_epu32(l1, maxl), l1));
+
+		lanes = _mm_movemask_ps(_mm_castsi128_ps(
+				_mm_or_si128(hit0, hit1)));
+		if (lanes != 0)
+			found |= lanes_to_modules(table, i, lanes);
+	}
+	return found;
+}
+
+__attribute__((target("avx2")))
+static uint64_t scan_avx2(const LPISigTable *table, uint32_t payload0,
+		uint32_t len0, uint32_t payload1, uint32_t len1) {
+
+	__m256i p0 = _mm256_set1_epi32(payload0);
+	__m256i l0 = _mm256_set1_epi32(len0);
+	__m256i p1 = _mm256_set1_epi32(payload1);
+	__m256i l1 = _mm256_set1_epi32(len1);
+	uint64_t found = 0;
+	uint32_t i;
+
+	for (i = 0; i < table->count; i += 8) {
+		__m256i value = _mm256_load_si256((const __m256i *)
+				(table->value + i));
+		__m256i mask = _mm256_load_si256((const __m256i *)
+				(table->mask + i));
+		__m256i minl = _mm256_load_si256((const __m256i *)
+				(table->min_len + i));
+		__m256i maxl = _mm256_load_si256((const __m256i *)
+				(table->max_len + i));
+		__m256i hit0, hit1;
+		int lanes;
+
+		hit0 = _mm256_cmpeq_epi32(_mm256_and_si256(p0, mask), value);
+		hit0 = _mm256_and_si256(hit0, _mm256_cmpeq_epi32(
+				_mm256_max_epu32(l0, minl), l0));
+		hit0 = _mm256_and_si256(hit0, _mm256_cmpeq_epi32(
+				_mm256_min_epu32(l0, maxl), l0));
+
+		hit1 = _mm256_cmpeq_epi32(_mm256_and_si256(p1, mask), value);
+		hit1 = _mm256_and_si256(hit1, _mm256_cmpeq_epi32(
+				_mm256_max_epu32(l1, minl), l1));
+		hit1 = _mm256_and_si256(hit1, _mm256_cmpeq_epi32(
+				_mm256_min_epu32(l1, maxl), l1));
+
+		lanes = _mm256_movemask_ps(_mm256_castsi256_ps(
+				_mm256_or_si256(hit0, hit1)));
+		if (lanes != 0)
+			found |= lanes_to_modules(table, i, lanes);
+	}
+	return found;
+}
+
+#endif
+
+/* Picks the widest kernel that the CPU supports */
+static void choose_kernel(LPISigTable *table) {
+
+	table->scan = scan_scalar;
+
+#ifdef LPI_SIG_SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		table->scan = scan_avx2;
+	else if (__builtin_cpu_supports("sse4.2"))
+		table->scan = scan_sse42;
+#endif
+}
+
+int build_sig_table(LPISigTable *table, const lpi_signature_t **sigs, 
+		uint32_t count) {
+
+	const lpi_signature_t *sig;
+	uint32_t i, n = 0, total = 0;
+	void *mem;
+
+	free_sig_table(table);
+
+	for (i = 0; i < count; i++) {
+		for (sig = sigs[i]; sig->mask != 0; sig++)
+			total ++;
+	}
+
+	if (total == 0)
+		return 0;
+	
+	total = (total + LPI_SIG_SCAN_LANES - 1) & ~(LPI_SIG_SCAN_LANES - 1);
+
+	/* One aligned block holds all four word arrays, so that the kernels
+	 * can use aligned loads */
+	if (posix_memalign(&mem, 32, total * 4 * sizeof(uint32_t)) != 0) {
+		fprintf(stderr, "Unable to allocate memory for signature table\n");
+		return -1;
+	}
+	table->module = (uint8_t *)calloc(total, sizeof(uint8_t));
+	if (table->module == NULL) {
+		free(mem);
+		fprintf(stderr, "Unable to allocate memory for signature table\n");
+		return -1;
+	}
+
+	table->value = (uint32_t *)mem;
+	table->mask = table->value + total;
+	table->min_len = table->mask + total;
+	table->max_len = table->min_len + total;
+
+	for (i = 0; i < count; i++) {
+		for (sig = sigs[i]; sig->mask != 0; sig++) {
+			table->value[n] = sig->value;
+			table->mask[n] = sig->mask;
+			table->min_len[n] = sig->min_len;
+			table->max_len[n] = (sig->max_len == 0) ? 
+					UINT32_MAX : sig->max_len;
+			table->module[n] = i;
+			n ++;
+		}
+	}
+
+	/* Padding: no payload ANDed with a zero mask can give a non-zero 
+	 * value */
+	for (; n < total; n++) {
+		table->value[n] = 1;
+		table->mask[n] = 0;
+		table->min_len[n] = 0;
+		table->max_len[n] = UINT32_MAX;
+	}
+
+	table->count = total;
+	choose_kernel(table);
+	return 0;
+}
+
+void free_sig_table(LPISigTable *table) {
+
+	/* The other arrays live in the same block as the values */
+	if (table->value != NULL)
+		free(table->value);
+	if (table->module != NULL)
+		free(table->module);
+	table->value = NULL;
+	table->mask = NULL;
+	table->min_len = NULL;
+	table->max_len = NULL;
+	table->module = NULL;
+	table->count = 0;
+}
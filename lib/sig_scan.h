@@ -0,0 +1,101 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Vectorised test of a flow against every payload signature in a dispatch
+ * table.
+ *
+ * The signatures declared by the modules in a table are copied into a
+ * structure-of-arrays table when the dispatch table is built. Testing a 
+ * flow then compares both payload words (and lengths) against all of the 
+ * signatures at once, using AVX2 or SSE4.2 where the CPU supports them, and
+ * gives back a bitset with one bit per module that has a matching 
+ * signature. The kernel is chosen when the table is built, based on what
+ * the CPU reports it can do.
+ *
+ * Each module with signatures is given a bit in that bitset (sig_bit in 
+ * its dispatch entry). Only the first LPI_SIG_SCAN_MODULES modules in a 
+ * table get one -- any others are given LPI_SIG_UNSCANNED instead and 
+ * have their signatures tested one at a time.
+ */
+
+#ifndef SIG_SCAN_H_
+#define SIG_SCAN_H_
+
+#include <stdint.h>
+
+#include "libprotoident.h"
+
+/* The number of signatures tested by each step of the widest kernel. The
+ * arrays are padded out to a multiple of this with signatures that can 
+ * never match */
+#define LPI_SIG_SCAN_LANES 8
+
+/* The most modules that can be given a bit in the scan result. The top bit
+ * is never set by a scan */
+#define LPI_SIG_SCAN_MODULES 63
+#define LPI_SIG_UNSCANNED ((uint64_t)1 << 63)
+
+typedef struct lpi_sig_table LPISigTable;
+
+typedef uint64_t (*LPISigScanFunc)(const LPISigTable *table, 
+		uint32_t payload0, uint32_t len0, uint32_t payload1, 
+		uint32_t len1);
+
+struct lpi_sig_table {
+	uint32_t count;		/* Number of signatures, including padding */
+	uint32_t *value;
+	uint32_t *mask;
+	uint32_t *min_len;
+	uint32_t *max_len;	/* UINT32_MAX if there is no limit */
+	uint8_t *module;	/* Bit for the module the signature came from */
+
+	LPISigScanFunc scan;	/* The kernel chosen for this CPU */
+};
+
+/* Builds the table from the signature lists of 'count' modules, where the
+ * signatures in sigs[i] belong to the module with bit i */
+int build_sig_table(LPISigTable *table, const lpi_signature_t **sigs, 
+		uint32_t count);
+void free_sig_table(LPISigTable *table);
+
+/* Returns a bitset of the modules that have a signature matching either 
+ * payload of a flow */
+static inline uint64_t scan_signatures(const LPISigTable *table, 
+		uint32_t payload0, uint32_t len0, uint32_t payload1, 
+		uint32_t len1) {
+
+	if (table->count == 0)
+		return 0;
+	return table->scan(table, payload0, len0, payload1, len1);
+}
+
+#endif
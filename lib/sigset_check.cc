@@ -0,0 +1,484 @@
+/*
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Exhaustive check for the hashed signature sets.
+ *
+ * match_http_request(), match_file_header() and the whois address test 
+ * used to be long chains of MATCH() tests, which have since been replaced
+ * with lpi_sigset_t lookups and byte class tests. This tests every 
+ * possible payload word against both the current code and the original 
+ * chains (copied below), for each payload length that the chains treat
+ * differently, and complains about any word where the two disagree.
+ *
+ * Every word is tried, so this takes a few minutes. Run using 
+ * 'make sigset-check'.
+ */
+
+#define __STDC_FORMAT_MACROS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* The headers used by the whois module must be included here first, so 
+ * that their include guards stop them being pulled into its namespace */
+#include "libprotoident.h"
+#include "proto_manager.h"
+#include "proto_common.h"
+
+namespace whois {
+#include "tcp/lpi_whois.cc"
+}
+
+/* The original versions of the tests */
+namespace linear {
+
+static bool match_http_request(uint32_t payload, uint32_t len) {
+
+        /* HTTP requests - some of these are MS-specific extensions */
+        if (len == 0)
+                return true;
+
+        if (MATCHSTR(payload, "GET ")) return true;
+        if (len == 1 && MATCH(payload, 'G', 0x00, 0x00, 0x00))
+                return true;
+        if (len == 2 && MATCH(payload, 'G', 'E', 0x00, 0x00))
+                return true;
+        if (len == 3 && MATCH(payload, 'G', 'E', 'T', 0x00))
+                return true;
+
+        if (MATCHSTR(payload, "POST")) return true;
+        if (MATCHSTR(payload, "HEAD")) return true;
+        if (MATCHSTR(payload, "PUT ")) return true;
+        if (MATCHSTR(payload, "DELE")) return true;
+        if (MATCHSTR(payload, "auth")) return true;
+
+        /* SVN? */
+        if (MATCHSTR(payload, "REPO")) return true;
+
+        /* Webdav */
+        if (MATCHSTR(payload, "LOCK")) return true;
+        if (MATCHSTR(payload, "UNLO")) return true;
+        if (MATCHSTR(payload, "OPTI")) return true;
+        if (MATCHSTR(payload, "PROP")) return true;
+        if (MATCHSTR(payload, "MKCO")) return true;
+        if (MATCHSTR(payload, "POLL")) return true;
+        if (MATCHSTR(payload, "SEAR")) return true;
+
+        /* Ntrip - some differential GPS system using modified HTTP */
+        if (MATCHSTR(payload, "SOUR")) return true;
+
+
+        return false;
+
+}
+
+static bool match_file_header(uint32_t payload) {
+
+        /* RIFF is a meta-format for storing AVI and WAV files */
+        if (MATCHSTR(payload, "RIFF"))
+                return true;
+
+        /* MZ is a .exe file */
+        if (MATCH(payload, 'M', 'Z', ANY, 0x00))
+                return true;
+
+        /* Ogg files */
+        if (MATCHSTR(payload, "OggS"))
+                return true;
+
+        /* ZIP files */
+        if (MATCH(payload, 'P', 'K', 0x03, 0x04))
+                return true;
+
+        /* MPEG files */
+        if (MATCH(payload, 0x00, 0x00, 0x01, 0xba))
+                return true;
+
+        /* RAR files */
+        if (MATCHSTR(payload, "Rar!"))
+                return true;
+
+        /* EBML */
+        if (MATCH(payload, 0x1a, 0x45, 0xdf, 0xa3))
+                return true;
+
+        /* JPG */
+        if (MATCH(payload, 0xff, 0xd8, ANY, ANY))
+                return true;
+
+        /* GIF */
+        if (MATCHSTR(payload, "GIF8"))
+                return true;
+
+        /* I'm also going to include PHP scripts in here */
+        if (MATCH(payload, 0x3c, 0x3f, 0x70, 0x68))
+                return true;
+
+        /* Unix scripts */
+        if (MATCH(payload, 0x23, 0x21, 0x2f, 0x62))
+                return true;
+
+        /* PDFs */
+        if (MATCHSTR(payload, "%PDF"))
+                return true;
+
+        /* PNG */
+        if (MATCH(payload, 0x89, 'P', 'N', 'G'))
+                return true;
+
+        /* HTML */
+        if (MATCHSTR(payload, "<htm"))
+                return true;
+        if (MATCH(payload, 0x0a, '<', '!', 'D'))
+                return true;
+
+        /* 7zip */
+        if (MATCH(payload, 0x37, 0x7a, 0xbc, 0xaf))
+                return true;
+
+        /* gzip  - may need to replace last two bytes with ANY */
+        if (MATCH(payload, 0x1f, 0x8b, 0x08, ANY))
+                return true;
+
+        /* XML */
+        if (MATCHSTR(payload, "<!DO"))
+                return true;
+
+        /* FLAC */
+        if (MATCHSTR(payload, "fLaC"))
+                return true;
+
+        /* MP3 */
+        if (MATCH(payload, 'I', 'D', '3', 0x03))
+                return true;
+	if (MATCHSTR(payload, "\xff\xfb\x90\xc0"))
+		return true;
+
+        /* RPM */
+        if (MATCH(payload, 0xed, 0xab, 0xee, 0xdb))
+                return true;
+
+        /* Wz Patch */
+        if (MATCHSTR(payload, "WzPa"))
+                return true;
+
+        /* Flash Video */
+        if (MATCH(payload, 'F', 'L', 'V', 0x01))
+                return true;
+
+        /* .BKF (Microsoft Tape Format) */
+        if (MATCHSTR(payload, "TAPE"))
+                return true;
+
+        /* MS Office Doc file - this is unpleasantly geeky */
+        if (MATCH(payload, 0xd0, 0xcf, 0x11, 0xe0))
+                return true;
+
+        /* ASP */
+        if (MATCH(payload, 0x3c, 0x25, 0x40, 0x20))
+                return true;
+
+        /* WMS file */
+        if (MATCH(payload, 0x3c, 0x21, 0x2d, 0x2d))
+                return true;
+
+	/* ar archive, typically .deb files */
+	if (MATCHSTR(payload, "!<ar"))
+		return true;
+
+	/* Raw XML */
+	if (MATCHSTR(payload, "<?xm"))
+		return true;
+	if (MATCHSTR(payload, "<iq "))
+		return true;
+
+	/* SPF */
+	if (MATCHSTR(payload, "SPFI"))
+		return true;
+
+	/* ABIF - Applied Biosystems */
+	if (MATCHSTR(payload, "ABIF"))
+		return true;
+
+	/* bzip2 - other digits are also possible instead of 9 */
+	if (MATCH(payload, 'B', 'Z', 'h', '9'))
+		return true;
+
+        /* I'm pretty sure the following are files of some type or another.
+         * They crop up pretty often in our test data sets, so I'm going to
+         * put them in here.
+         *
+         * Hopefully one day we will find out what they really are */
+
+        if (MATCH(payload, '<', 'c', 'f', ANY))
+                return true;
+        if (MATCH(payload, '<', 'C', 'F', ANY))
+                return true;
+        if (MATCHSTR(payload, ".tem"))
+                return true;
+        if (MATCHSTR(payload, ".ite"))
+                return true;
+        if (MATCHSTR(payload, ".lef"))
+                return true;
+
+        return false;
+
+}
+
+static inline bool match_dot_second(uint32_t payload) {
+	if (MATCH(payload, ANY, '.', ANY, ANY))
+		return true;
+	return false;
+}
+
+static inline bool match_dot_third(uint32_t payload) {
+	if (MATCH(payload, ANY, ANY, '.', ANY))
+		return true;
+	return false;
+}
+
+static inline bool match_dot_last(uint32_t payload) {
+	if (MATCH(payload, ANY, ANY, ANY, '.'))
+		return true;
+	return false;
+}
+
+static inline bool match_digit_first(uint32_t payload) {
+
+	if (MATCH(payload, '1', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '2', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '3', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '4', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '5', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '6', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '7', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '8', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '9', ANY, ANY, ANY))
+		return true;
+	if (MATCH(payload, '0', ANY, ANY, ANY))
+		return true;
+	return false;
+}
+
+static inline bool match_digit_second(uint32_t payload) {
+
+	if (MATCH(payload, ANY, '1', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '2', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '3', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '4', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '5', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '6', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '7', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '8', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '9', ANY, ANY))
+		return true;
+	if (MATCH(payload, ANY, '0', ANY, ANY))
+		return true;
+	return false;
+}
+
+static inline bool match_digit_third(uint32_t payload) {
+
+	if (MATCH(payload, ANY, ANY, '1', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '2', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '3', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '4', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '5', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '6', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '7', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '8', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '9', ANY))
+		return true;
+	if (MATCH(payload, ANY, ANY, '0', ANY))
+		return true;
+	return false;
+}
+
+static inline bool match_digit_last(uint32_t payload) {
+
+	if (MATCH(payload, ANY, ANY, ANY, '1'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '2'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '3'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '4'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '5'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '6'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '7'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '8'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '9'))
+		return true;
+	if (MATCH(payload, ANY, ANY, ANY, '0'))
+		return true;
+	return false;
+}
+
+static inline bool match_ipv4_text(uint32_t payload) {
+
+	bool seen_dot = false;
+
+	/* Gotta start with a digit */
+	if (!match_digit_first(payload))
+		return false;
+
+	/* Matching the case 1.XX */
+	if (match_dot_second(payload)) {
+		/* Can't have two dots in a row */
+		if (!match_digit_third(payload))
+			return false;
+
+		/* We can have either two digits, e.g. 1.45 */
+		if (match_digit_last(payload))
+			return true;
+		/* Or a another dot, e.g. 1.1. */
+		if (match_dot_last(payload))
+			return true;
+		return false;
+	} 
+	
+	/* Not a dot so must be a digit, e.g. 11XX */
+	if (!match_digit_second(payload)) {
+		return false;
+	}
+
+	/* If the third character is a dot, then we need a digit as the last
+	 * e.g. 10.4 */
+	if (match_dot_third(payload)) {
+		if (!match_digit_last(payload))
+			return false;
+		return true;
+	} 
+
+	/* Third character must be a digit, then */
+	if (!match_digit_third(payload))
+		return false;
+
+	/* If we've got three digits, we must end on a dot - e.g. 192. */
+	if (match_dot_last(payload))
+		return true;
+
+	return false;
+}
+
+}
+
+/* The lengths to test match_http_request() with. The original chain only
+ * looks at lengths zero to three, so anything longer is the same as four */
+static const uint32_t http_lens[] = { 0, 1, 2, 3, 4, 5, 1460 };
+
+#define HTTP_LENS (sizeof(http_lens) / sizeof(http_lens[0]))
+
+static uint64_t mismatches = 0;
+
+static void mismatch(const char *test, uint32_t payload, uint32_t len) {
+
+	const uint8_t *b = (const uint8_t *)&payload;
+
+	if (mismatches < 10) {
+		fprintf(stderr, "Mismatch: %s disagrees for payload "
+				"%02x %02x %02x %02x, len %u\n", test, b[0], 
+				b[1], b[2], b[3], len);
+	}
+	mismatches ++;
+}
+
+int main(int argc, char *argv[]) {
+
+	uint64_t w;
+	uint32_t i;
+
+	if (lpi_init_library() == -1)
+		return 1;
+
+	/* Make sure the sets have been built, so that we are testing the 
+	 * hashed lookup rather than the fallback */
+	match_http_request(0, 4);
+	match_file_header(0);
+
+	for (w = 0; w <= 0xffffffffULL; w++) {
+		uint32_t payload = (uint32_t)w;
+
+		for (i = 0; i < HTTP_LENS; i++) {
+			if (match_http_request(payload, http_lens[i]) != 
+					linear::match_http_request(payload, 
+					http_lens[i]))
+				mismatch("match_http_request", payload, 
+						http_lens[i]);
+		}
+
+		if (match_file_header(payload) != 
+				linear::match_file_header(payload))
+			mismatch("match_file_header", payload, 0);
+
+		if (whois::match_ipv4_text(payload) != 
+				linear::match_ipv4_text(payload))
+			mismatch("whois match_ipv4_text", payload, 0);
+	}
+
+	lpi_free_library();
+
+	printf("%" PRIu64 " payload words checked, %" PRIu64 " mismatches\n", 
+			w, mismatches);
+	return (mismatches == 0) ? 0 : 1;
+}
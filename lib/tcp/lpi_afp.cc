@@ -45,12 +45,20 @@ static inline bool match_afp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t afp_sigs[] = {
+	LPI_SIG(0x00, 0x04, 0x00, 0x01),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_afp = {
 	LPI_PROTO_AFP,
 	LPI_CATEGORY_FILES,
 	"AFP",
 	5,
-	match_afp
+	match_afp,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	afp_sigs
 };
 
 void register_afp(LPIModuleMap *mod_map) {
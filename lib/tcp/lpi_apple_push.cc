@@ -60,13 +60,17 @@ static inline bool match_apple_push(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return true;
 }
 
+static const uint16_t apple_push_ports[] = { 5223, 0 };
+
 static lpi_module_t lpi_apple_push = {
 	LPI_PROTO_APPLE_PUSH,
 	LPI_CATEGORY_NOTIFICATION,
 	"ApplePush",
 	8, /* Should be a higher priority than regular SSL, but lower than
 	      anything else on port 5223  */
-	match_apple_push
+	match_apple_push,
+	LPI_PORTS_REQUIRED,
+	apple_push_ports
 };
 
 void register_apple_push(LPIModuleMap *mod_map) {
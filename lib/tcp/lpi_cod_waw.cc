@@ -55,12 +55,16 @@ static inline bool match_cod_waw(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t cod_waw_ports[] = { 3074, 0 };
+
 static lpi_module_t lpi_cod_waw = {
 	LPI_PROTO_COD_WAW,
 	LPI_CATEGORY_GAMING,
 	"Call_of_Duty_TCP",
 	10,	/* Weak rule */
-	match_cod_waw
+	match_cod_waw,
+	LPI_PORTS_REQUIRED,
+	cod_waw_ports
 };
 
 void register_cod_waw(LPIModuleMap *mod_map) {
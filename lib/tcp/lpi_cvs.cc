@@ -82,12 +82,20 @@ static inline bool match_cvs(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t cvs_sigs[] = {
+	LPI_SIG('B', 'E', 'G', 'I'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_cvs = {
 	LPI_PROTO_CVS,
 	LPI_CATEGORY_RCS,
 	"CVS",
 	3,
-	match_cvs
+	match_cvs,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	cvs_sigs
 };
 
 void register_cvs(LPIModuleMap *mod_map) {
@@ -73,10 +73,10 @@ static inline bool match_bulk_response(uint32_t payload, uint32_t len) {
 static inline bool match_bulk_download(lpi_data_t *data) {
 
         if (match_bulk_response(data->payload[1], data->payload_len[1]) &&
-                        match_file_header(data->payload[0]))
+                        has_file_header(data, 0))
                 return true;
         if (match_bulk_response(data->payload[0], data->payload_len[0]) &&
-                        match_file_header(data->payload[1]))
+                        has_file_header(data, 1))
                 return true;
 
         return false;
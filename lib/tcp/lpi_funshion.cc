@@ -70,12 +70,16 @@ static inline bool match_funshion_tcp(lpi_data_t *data, lpi_module_t *mod UNUSED
 
 }
 
+static const uint16_t funshion_tcp_ports[] = { 6601, 0 };
+
 static lpi_module_t lpi_funshion_tcp = {
 	LPI_PROTO_FUNSHION,
 	LPI_CATEGORY_P2PTV,
 	"Funshion_TCP",
 	10,
-	match_funshion_tcp
+	match_funshion_tcp,
+	LPI_PORTS_REQUIRED,
+	funshion_tcp_ports
 };
 
 void register_funshion_tcp(LPIModuleMap *mod_map) {
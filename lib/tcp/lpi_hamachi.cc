@@ -54,12 +54,16 @@ static inline bool match_hamachi(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t hamachi_ports[] = { 12975, 0 };
+
 static lpi_module_t lpi_hamachi = {
 	LPI_PROTO_HAMACHI,
 	LPI_CATEGORY_TUNNELLING,
 	"Hamachi",
 	4,
-	match_hamachi
+	match_hamachi,
+	LPI_PORTS_REQUIRED,
+	hamachi_ports
 };
 
 void register_hamachi(LPIModuleMap *mod_map) {
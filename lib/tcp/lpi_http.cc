@@ -37,25 +37,6 @@
 #include "proto_common.h"
 
 
-static inline bool match_http_response(uint32_t payload, uint32_t len) {
-
-        if (len == 0)
-                return true;
-        if (len == 1 && MATCH(payload, 'H', 0x00, 0x00, 0x00))
-                return true;
-        if (MATCHSTR(payload, "HTTP")) {
-                return true;
-        }
-
-        /* UNKNOWN seems to be a valid response from some servers, e.g.
-         * mini_httpd */
-        if (MATCHSTR(payload, "UNKN")) {
-                return true;
-        }
-
-        return false;
-}
-
 static inline bool match_http(lpi_data_t *data, lpi_module_t *mod) {
 
 
@@ -67,28 +48,28 @@ static inline bool match_http(lpi_data_t *data, lpi_module_t *mod) {
                         return false;
         }
 
-        if (match_http_request(data->payload[0], data->payload_len[0])) {
-                if (match_http_response(data->payload[1], data->payload_len[1]))
+        if (has_http_request(data, 0)) {
+                if (has_http_response(data, 1))
                         return true;
-                if (match_http_request(data->payload[1], data->payload_len[1]))
+                if (has_http_request(data, 1))
                         return true;
-                if (match_file_header(data->payload[1]) &&
+                if (has_file_header(data, 1) &&
                                 data->payload_len[0] != 0)
                         return true;
         }
 
-        if (match_http_request(data->payload[1], data->payload_len[1])) {
-                if (match_http_response(data->payload[0], data->payload_len[0]))
+        if (has_http_request(data, 1)) {
+                if (has_http_response(data, 0))
                         return true;
-                if (match_file_header(data->payload[0]) &&
+                if (has_file_header(data, 0) &&
                                 data->payload_len[1] != 0)
                         return true;
         }
 
         /* Allow responses in both directions, even if this is doesn't entirely
          * make sense :/ */
-        if (match_http_response(data->payload[0], data->payload_len[0])) {
-                if (match_http_response(data->payload[1], data->payload_len[1]))
+        if (has_http_response(data, 0)) {
+                if (has_http_response(data, 1))
                         return true;
         }
 
@@ -56,12 +56,16 @@ static inline bool match_http_badport(lpi_data_t *data, lpi_module_t *mod) {
 
 }
 
+static const uint16_t http_badport_ports[] = { 443, 0 };
+
 static lpi_module_t lpi_http_badport = {
 	LPI_PROTO_HTTP_BADPORT,
 	LPI_CATEGORY_WEB,
 	"HTTP_443",
 	2,
-	match_http_badport
+	match_http_badport,
+	LPI_PORTS_REQUIRED,
+	http_badport_ports
 };
 
 void register_http_badport(LPIModuleMap *mod_map) {
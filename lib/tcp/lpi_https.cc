@@ -52,12 +52,16 @@ static inline bool match_https(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t https_ports[] = { 443, 80, 0 };
+
 static lpi_module_t lpi_https = {
 	LPI_PROTO_HTTPS,
 	LPI_CATEGORY_WEB,
 	"HTTPS",
 	2, /* Should be higher priority than regular SSL */
-	match_https
+	match_https,
+	LPI_PORTS_REQUIRED,
+	https_ports
 };
 
 void register_https(LPIModuleMap *mod_map) {
@@ -43,12 +43,20 @@ static inline bool match_imap(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const lpi_signature_t imap_sigs[] = {
+	LPI_SIG('*', ' ', 'O', 'K'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_imap = {
 	LPI_PROTO_IMAP,
 	LPI_CATEGORY_MAIL,
 	"IMAP",
 	2,
-	match_imap
+	match_imap,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	imap_sigs
 };
 
 void register_imap(LPIModuleMap *mod_map) {
@@ -48,12 +48,16 @@ static inline bool match_imaps(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t imaps_ports[] = { 993, 0 };
+
 static lpi_module_t lpi_imaps = {
 	LPI_PROTO_IMAPS,
 	LPI_CATEGORY_MAIL,
 	"IMAPS",
 	2, /* Should be a higher priority than regular SSL */
-	match_imaps
+	match_imaps,
+	LPI_PORTS_REQUIRED,
+	imaps_ports
 };
 
 void register_imaps(LPIModuleMap *mod_map) {
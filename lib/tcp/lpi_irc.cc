@@ -61,12 +61,16 @@ static inline bool match_irc(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t irc_ports[] = { 6667, 0 };
+
 static lpi_module_t lpi_irc = {
 	LPI_PROTO_IRC,
 	LPI_CATEGORY_CHAT,
 	"IRC",
 	2,
-	match_irc
+	match_irc,
+	LPI_PORTS_PREFERRED,
+	irc_ports
 };
 
 void register_irc(LPIModuleMap *mod_map) {
@@ -45,12 +45,16 @@ static inline bool match_kaspersky_tcp(lpi_data_t *data,
 	return match_kaspersky(data);
 }
 
+static const uint16_t kaspersky_ports[] = { 443, 0 };
+
 static lpi_module_t lpi_kaspersky = {
 	LPI_PROTO_KASPERSKY,
 	LPI_CATEGORY_SECURITY,
 	"Kaspersky_TCP",
 	4,
-	match_kaspersky_tcp
+	match_kaspersky_tcp,
+	LPI_PORTS_REQUIRED,
+	kaspersky_ports
 };
 
 void register_kaspersky(LPIModuleMap *mod_map) {
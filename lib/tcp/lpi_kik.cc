@@ -73,12 +73,16 @@ static inline bool match_kik(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t kik_ports[] = { 5223, 0 };
+
 static lpi_module_t lpi_kik = {
 	LPI_PROTO_KIK,
 	LPI_CATEGORY_CHAT,
 	"Kik",
 	5, /* Should be a higher priority than ApplePush */
-	match_kik
+	match_kik,
+	LPI_PORTS_REQUIRED,
+	kik_ports
 };
 
 void register_kik(LPIModuleMap *mod_map) {
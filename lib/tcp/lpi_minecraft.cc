@@ -69,7 +69,7 @@ static inline bool match_mc_kick(uint32_t payload, uint32_t len) {
 	 * so we just have to check that the length makes sense given the size
 	 * of the packet */
 
-	str_len = (ntohl(payload) >> 8) & 0xffff;
+	str_len = PAYLOAD_FIELD16(payload, 1);
 
 	if (str_len >= len)
 		return false;
@@ -74,12 +74,16 @@ static inline bool match_mysql(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t mysql_ports[] = { 3306, 0 };
+
 static lpi_module_t lpi_mysql = {
 	LPI_PROTO_MYSQL,
 	LPI_CATEGORY_DATABASES,
 	"MySQL",
 	4,
-	match_mysql
+	match_mysql,
+	LPI_PORTS_PREFERRED,
+	mysql_ports
 };
 
 void register_mysql(LPIModuleMap *mod_map) {
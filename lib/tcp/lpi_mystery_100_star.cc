@@ -81,12 +81,20 @@ static inline bool match_mystery_100_star(lpi_data_t *data, lpi_module_t *mod UN
 	return false;
 }
 
+static const lpi_signature_t mystery_100_star_sigs[] = {
+	LPI_SIG_LEN('1', '0', '0', ' ', 15, 15),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_100_star = {
 	LPI_PROTO_MYSTERY_100_STAR,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_100_STAR",
 	250,
-	match_mystery_100_star
+	match_mystery_100_star,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_100_star_sigs
 };
 
 void register_mystery_100_star(LPIModuleMap *mod_map) {
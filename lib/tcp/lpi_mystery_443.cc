@@ -38,7 +38,6 @@
 
 static inline bool check_length(uint32_t payload, uint32_t len) {
 	uint16_t *lenptr;
-	uint32_t swap;
 	
 	uint32_t length;
 
@@ -46,9 +45,7 @@ static inline bool check_length(uint32_t payload, uint32_t len) {
 			MATCH(payload, ANY, ANY, 0x2d, ANY)))
 		return false;
 	
-	swap=ntohl(payload);
-
-	length = swap >> 16;
+	length = PAYLOAD_FIELD16(payload, 0);
 
 	if (length != len)
 		return false;
@@ -55,12 +55,20 @@ static inline bool match_mystery_conn(lpi_data_t *data, lpi_module_t *mod UNUSED
 	return false;
 }
 
+static const lpi_signature_t mystery_conn_sigs[] = {
+	LPI_SIG('r', 'e', 'c', 'i'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_conn = {
 	LPI_PROTO_MYSTERY_CONN,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_conn",
 	250,
-	match_mystery_conn
+	match_mystery_conn,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_conn_sigs
 };
 
 void register_mystery_conn(LPIModuleMap *mod_map) {
@@ -57,12 +57,20 @@ static inline bool match_mystery_iG(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const lpi_signature_t mystery_iG_sigs[] = {
+	LPI_SIG(0xd7, 0x69, 0x47, 0x26),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_iG = {
 	LPI_PROTO_MYSTERY_IG,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_iG",
 	250,
-	match_mystery_iG
+	match_mystery_iG,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_iG_sigs
 };
 
 void register_mystery_iG(LPIModuleMap *mod_map) {
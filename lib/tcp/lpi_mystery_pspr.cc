@@ -51,12 +51,20 @@ static inline bool match_mystery_pspr(lpi_data_t *data, lpi_module_t *mod UNUSED
 	return false;
 }
 
+static const lpi_signature_t mystery_pspr_sigs[] = {
+	LPI_SIG('P', 'S', 'P', 'r'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_pspr = {
 	LPI_PROTO_MYSTERY_PSPR,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_PSPR",
 	250,
-	match_mystery_pspr
+	match_mystery_pspr,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_pspr_sigs
 };
 
 void register_mystery_pspr(LPIModuleMap *mod_map) {
@@ -52,12 +52,20 @@ static inline bool match_mystery_rxxf(lpi_data_t *data,
 	return false;
 }
 
+static const lpi_signature_t mystery_rxxf_sigs[] = {
+	LPI_SIG('R', 'X', 'X', 'F'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_rxxf = {
 	LPI_PROTO_MYSTERY_RXXF,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_RXXF",
 	250,
-	match_mystery_rxxf
+	match_mystery_rxxf,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_rxxf_sigs
 };
 
 void register_mystery_rxxf(LPIModuleMap *mod_map) {
@@ -64,12 +64,16 @@ static inline bool match_mystery_symantec(lpi_data_t *data,
 	return false;
 }
 
+static const uint16_t mystery_symantec_ports[] = { 80, 0 };
+
 static lpi_module_t lpi_mystery_symantec = {
 	LPI_PROTO_MYSTERY_SYMANTEC,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_Symantec",
 	250,
-	match_mystery_symantec
+	match_mystery_symantec,
+	LPI_PORTS_REQUIRED,
+	mystery_symantec_ports
 };
 
 void register_mystery_symantec(LPIModuleMap *mod_map) {
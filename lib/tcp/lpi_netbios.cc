@@ -41,13 +41,13 @@ static inline bool match_netbios(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	uint32_t stated_len = 0;
 
         if (MATCH(data->payload[0], 0x81, 0x00, ANY, ANY)) {
-                stated_len = ntohl(data->payload[0]) & 0xffff;
+                stated_len = PAYLOAD_FIELD16(data->payload[0], 2);
                 if (stated_len == data->payload_len[0] - 4)
                         return true;
         }
 
         if (MATCH(data->payload[1], 0x81, 0x00, ANY, ANY)) {
-                stated_len = ntohl(data->payload[1]) & 0xffff;
+                stated_len = PAYLOAD_FIELD16(data->payload[1], 2);
                 if (stated_len == data->payload_len[1] - 4)
                         return true;
         }
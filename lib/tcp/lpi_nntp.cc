@@ -55,12 +55,25 @@ static inline bool match_nntp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t nntp_sigs[] = {
+	LPI_SIG('m', 'o', 'd', 'e'),
+	LPI_SIG('M', 'O', 'D', 'E'),
+	LPI_SIG('G', 'R', 'O', 'U'),
+	LPI_SIG('g', 'r', 'o', 'u'),
+	LPI_SIG('A', 'U', 'T', 'H'),
+	LPI_SIG('a', 'u', 't', 'h'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_nntp = {
 	LPI_PROTO_NNTP,
 	LPI_CATEGORY_NEWS,
 	"NNTP",
 	4,
-	match_nntp
+	match_nntp,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	nntp_sigs
 };
 
 void register_nntp(LPIModuleMap *mod_map) {
@@ -50,12 +50,16 @@ static inline bool match_nntps(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return true;
 }
 
+static const uint16_t nntps_ports[] = { 563, 0 };
+
 static lpi_module_t lpi_nntps = {
 	LPI_PROTO_NNTPS,
 	LPI_CATEGORY_NEWS,
 	"NNTPS",
 	5, /* Should be a higher priority than regular SSL */
-	match_nntps
+	match_nntps,
+	LPI_PORTS_REQUIRED,
+	nntps_ports
 };
 
 void register_nntps(LPIModuleMap *mod_map) {
@@ -60,12 +60,23 @@ static inline bool match_pop3(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const lpi_signature_t pop3_sigs[] = {
+	LPI_SIG('+', 'O', 'K', ANY),
+	LPI_SIG('-', 'E', 'R', 'R'),
+	LPI_SIG('C', 'A', 'P', 'A'),
+	LPI_SIG('A', 'U', 'T', 'H'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_pop3 = {
 	LPI_PROTO_POP3,
 	LPI_CATEGORY_MAIL,
 	"POP3",
 	2,
-	match_pop3
+	match_pop3,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	pop3_sigs
 };
 
 void register_pop3(LPIModuleMap *mod_map) {
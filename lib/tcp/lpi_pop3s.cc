@@ -48,12 +48,16 @@ static inline bool match_pop3s(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t pop3s_ports[] = { 995, 0 };
+
 static lpi_module_t lpi_pop3s = {
 	LPI_PROTO_POP3S,
 	LPI_CATEGORY_MAIL,
 	"POP3S",
 	2, /* Should be a higher priority than regular SSL */
-	match_pop3s
+	match_pop3s,
+	LPI_PORTS_REQUIRED,
+	pop3s_ports
 };
 
 void register_pop3s(LPIModuleMap *mod_map) {
@@ -56,12 +56,16 @@ static inline bool match_psn_store(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t psn_store_ports[] = { 5223, 0 };
+
 static lpi_module_t lpi_psn_store = {
 	LPI_PROTO_PSN_STORE,
 	LPI_CATEGORY_GAMING,
 	"PSNStore",
 	2, /* Should be a higher priority than regular SSL */
-	match_psn_store
+	match_psn_store,
+	LPI_PORTS_REQUIRED,
+	psn_store_ports
 };
 
 void register_psn_store(LPIModuleMap *mod_map) {
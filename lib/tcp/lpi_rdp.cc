@@ -103,12 +103,16 @@ static bool match_rdp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t rdp_ports[] = { 3389, 0 };
+
 static lpi_module_t lpi_rdp = {
 	LPI_PROTO_RDP,
 	LPI_CATEGORY_REMOTE,
 	"RDP",
 	4, /*  Moving this to 4 purely on gut feeling */
-	match_rdp
+	match_rdp,
+	LPI_PORTS_PREFERRED,
+	rdp_ports
 };
 
 void register_rdp(LPIModuleMap *mod_map) {
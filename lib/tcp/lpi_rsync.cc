@@ -43,12 +43,20 @@ static inline bool match_rsync(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t rsync_sigs[] = {
+	LPI_SIG('@', 'R', 'S', 'Y'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_rsync = {
 	LPI_PROTO_RSYNC,
 	LPI_CATEGORY_FILES,
 	"Rsync",
 	3,
-	match_rsync
+	match_rsync,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	rsync_sigs
 };
 
 void register_rsync(LPIModuleMap *mod_map) {
@@ -43,12 +43,20 @@ static inline bool match_rtsp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t rtsp_sigs[] = {
+	LPI_SIG('R', 'T', 'S', 'P'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_rtsp = {
 	LPI_PROTO_RTSP,
 	LPI_CATEGORY_STREAMING,
 	"RTSP",
 	2,
-	match_rtsp
+	match_rtsp,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	rtsp_sigs
 };
 
 void register_rtsp(LPIModuleMap *mod_map) {
@@ -61,12 +61,16 @@ static inline bool match_second_life(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t second_life_ports[] = { 12043, 12046, 0 };
+
 static lpi_module_t lpi_second_life = {
 	LPI_PROTO_SECONDLIFE,
 	LPI_CATEGORY_GAMING,
 	"SecondLife",
 	6,
-	match_second_life
+	match_second_life,
+	LPI_PORTS_REQUIRED,
+	second_life_ports
 };
 
 void register_second_life(LPIModuleMap *mod_map) {
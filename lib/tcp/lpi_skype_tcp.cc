@@ -70,12 +70,16 @@ static inline bool match_skype_tcp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t skype_tcp_ports[] = { 12350, 13392, 0 };
+
 static lpi_module_t lpi_skype_tcp = {
 	LPI_PROTO_SKYPE_TCP,
 	LPI_CATEGORY_VOIP,
 	"SkypeTCP",
 	20, /* Should be a higher priority than regular SSL */
-	match_skype_tcp
+	match_skype_tcp,
+	LPI_PORTS_REQUIRED,
+	skype_tcp_ports
 };
 
 void register_skype_tcp(LPIModuleMap *mod_map) {
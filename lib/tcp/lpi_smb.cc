@@ -87,12 +87,16 @@ static inline bool match_smb(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t smb_ports[] = { 445, 0 };
+
 static lpi_module_t lpi_smb = {
 	LPI_PROTO_SMB,
 	LPI_CATEGORY_FILES,
 	"SMB",
 	3,
-	match_smb
+	match_smb,
+	LPI_PORTS_REQUIRED,
+	smb_ports
 };
 
 void register_smb(LPIModuleMap *mod_map) {
@@ -51,12 +51,16 @@ static inline bool match_smtps(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return true;
 }
 
+static const uint16_t smtps_ports[] = { 465, 0 };
+
 static lpi_module_t lpi_smtps = {
 	LPI_PROTO_SMTPS,
 	LPI_CATEGORY_MAIL,
 	"SMTP_Secure",
 	5, /* Should be a higher priority than regular SSL */
-	match_smtps
+	match_smtps,
+	LPI_PORTS_REQUIRED,
+	smtps_ports
 };
 
 void register_smtps(LPIModuleMap *mod_map) {
@@ -46,7 +46,7 @@ static inline bool match_spotify_02_req(uint32_t payload, uint32_t len) {
 		return false;
 	
 	/* The last byte is the length of the packet - 256 */
-	len_field = (ntohl(payload)) & 0xff;
+	len_field = PAYLOAD_BYTE(payload, 3);
 
 	if (len_field == len - 256)
 		return true;
@@ -115,12 +115,16 @@ static inline bool match_spotify(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t spotify_ports[] = { 4070, 443, 0 };
+
 static lpi_module_t lpi_spotify = {
 	LPI_PROTO_SPOTIFY,
 	LPI_CATEGORY_STREAMING,
 	"Spotify",
 	7,
-	match_spotify
+	match_spotify,
+	LPI_PORTS_REQUIRED,
+	spotify_ports
 };
 
 void register_spotify(LPIModuleMap *mod_map) {
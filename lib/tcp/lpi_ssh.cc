@@ -75,12 +75,16 @@ static inline bool match_ssh(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t ssh_ports[] = { 22, 0 };
+
 static lpi_module_t lpi_ssh = {
 	LPI_PROTO_SSH,
 	LPI_CATEGORY_REMOTE,
 	"SSH",
 	2,
-	match_ssh
+	match_ssh,
+	LPI_PORTS_PREFERRED,
+	ssh_ports
 };
 
 void register_ssh(LPIModuleMap *mod_map) {
@@ -72,12 +72,16 @@ static inline bool match_supl(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t supl_ports[] = { 7275, 0 };
+
 static lpi_module_t lpi_supl = {
 	LPI_PROTO_SUPL,
 	LPI_CATEGORY_LOCATION,
 	"SUPL",
 	12,
-	match_supl
+	match_supl,
+	LPI_PORTS_REQUIRED,
+	supl_ports
 };
 
 void register_supl(LPIModuleMap *mod_map) {
@@ -71,12 +71,20 @@ static inline bool match_svn(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const lpi_signature_t svn_sigs[] = {
+	LPI_SIG('(', ' ', 's', 'u'),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_svn = {
 	LPI_PROTO_SVN,
 	LPI_CATEGORY_RCS,
 	"SVN",
 	3,
-	match_svn
+	match_svn,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	svn_sigs
 };
 
 void register_svn(LPIModuleMap *mod_map) {
@@ -45,7 +45,7 @@ static inline bool match_tds_response(uint32_t payload, uint32_t len) {
 
         if (!MATCH(payload, 0x04, 0x01, ANY, ANY))
                 return false;
-        stated_len = (ntohl(payload) & 0xffff);
+        stated_len = PAYLOAD_FIELD16(payload, 2);
         if (stated_len != len)
                 return false;
 
@@ -43,7 +43,7 @@ static inline bool match_teamviewer_payload(uint32_t payload, uint32_t len) {
 	if (!MATCH(payload, 0x17, 0x24, ANY, ANY))
 		return false;
 
-	if ((ntohl(payload) & 0xff) != len - 5)
+	if (PAYLOAD_BYTE(payload, 3) != len - 5)
 		return false;
 	
 	return true;
@@ -65,12 +65,16 @@ static inline bool match_telnet_exploit(lpi_data_t *data, lpi_module_t *mod UNUS
 	return false;
 }
 
+static const uint16_t telnet_exploit_ports[] = { 23, 0 };
+
 static lpi_module_t lpi_telnet_exploit = {
 	LPI_PROTO_TELNET_EXPLOIT,
 	LPI_CATEGORY_MALWARE,
 	"TelnetExploit",
 	20,
-	match_telnet_exploit
+	match_telnet_exploit,
+	LPI_PORTS_REQUIRED,
+	telnet_exploit_ports
 };
 
 void register_telnet_exploit(LPIModuleMap *mod_map) {
@@ -90,12 +90,16 @@ static inline bool match_trojan_win32_generic_sb(lpi_data_t *data, lpi_module_t
 	return false;
 }
 
+static const uint16_t trojan_win32_generic_sb_ports[] = { 3000, 0 };
+
 static lpi_module_t lpi_trojan_win32_generic_sb = {
 	LPI_PROTO_TROJAN_WIN32_GENERIC_SB,
 	LPI_CATEGORY_MALWARE,
 	"Trojan.Win32.Generic!SB",
 	10,
-	match_trojan_win32_generic_sb
+	match_trojan_win32_generic_sb,
+	LPI_PORTS_REQUIRED,
+	trojan_win32_generic_sb_ports
 };
 
 void register_trojan_win32_generic_sb(LPIModuleMap *mod_map) {
@@ -47,12 +47,12 @@ static inline bool match_web_junk(lpi_data_t *data, lpi_module_t *mod UNUSED) {
         if (data->payload_len[0] == 0 || data->payload_len[1] == 0)
                 return false;
 
-        if (!match_http_request(data->payload[0], data->payload_len[0])) {
+        if (!has_http_request(data, 0)) {
                 if (MATCHSTR(data->payload[1], "HTTP"))
                         return true;
         }
 
-        if (!match_http_request(data->payload[1], data->payload_len[1])) {
+        if (!has_http_request(data, 1)) {
                 if (MATCHSTR(data->payload[0], "HTTP"))
                         return true;
         }
@@ -101,12 +101,16 @@ static inline bool match_wechat(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t wechat_ports[] = { 80, 8080, 443, 0 };
+
 static lpi_module_t lpi_wechat = {
 	LPI_PROTO_WECHAT,
 	LPI_CATEGORY_CHAT,
 	"WeChat",
 	10, 
-	match_wechat
+	match_wechat,
+	LPI_PORTS_REQUIRED,
+	wechat_ports
 };
 
 void register_wechat(LPIModuleMap *mod_map) {
@@ -36,122 +36,18 @@
 #include "proto_manager.h"
 #include "proto_common.h"
 
-static inline bool match_dot_second(uint32_t payload) {
-	if (MATCH(payload, ANY, '.', ANY, ANY))
-		return true;
-	return false;
-}
-
-static inline bool match_dot_third(uint32_t payload) {
-	if (MATCH(payload, ANY, ANY, '.', ANY))
-		return true;
-	return false;
-}
-
-static inline bool match_dot_last(uint32_t payload) {
-	if (MATCH(payload, ANY, ANY, ANY, '.'))
-		return true;
-	return false;
-}
-
-static inline bool match_digit_first(uint32_t payload) {
-
-	if (MATCH(payload, '1', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '2', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '3', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '4', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '5', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '6', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '7', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '8', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '9', ANY, ANY, ANY))
-		return true;
-	if (MATCH(payload, '0', ANY, ANY, ANY))
-		return true;
-	return false;
-}
-
-static inline bool match_digit_second(uint32_t payload) {
-
-	if (MATCH(payload, ANY, '1', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '2', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '3', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '4', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '5', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '6', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '7', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '8', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '9', ANY, ANY))
-		return true;
-	if (MATCH(payload, ANY, '0', ANY, ANY))
-		return true;
-	return false;
+/* Returns the given byte of the payload, counting from the first byte on
+ * the wire */
+static inline uint8_t payload_byte(uint32_t payload, int byte) {
+	return ((uint8_t *)&payload)[byte];
 }
 
-static inline bool match_digit_third(uint32_t payload) {
-
-	if (MATCH(payload, ANY, ANY, '1', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '2', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '3', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '4', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '5', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '6', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '7', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '8', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '9', ANY))
-		return true;
-	if (MATCH(payload, ANY, ANY, '0', ANY))
-		return true;
-	return false;
+static inline bool match_dot(uint32_t payload, int byte) {
+	return payload_byte(payload, byte) == '.';
 }
 
-static inline bool match_digit_last(uint32_t payload) {
-
-	if (MATCH(payload, ANY, ANY, ANY, '1'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '2'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '3'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '4'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '5'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '6'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '7'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '8'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '9'))
-		return true;
-	if (MATCH(payload, ANY, ANY, ANY, '0'))
-		return true;
-	return false;
+static inline bool match_digit(uint32_t payload, int byte) {
+	return (uint8_t)(payload_byte(payload, byte) - '0') < 10;
 }
 
 static inline bool match_ipv4_text(uint32_t payload) {
@@ -159,43 +55,43 @@ static inline bool match_ipv4_text(uint32_t payload) {
 	bool seen_dot = false;
 
 	/* Gotta start with a digit */
-	if (!match_digit_first(payload))
+	if (!match_digit(payload, 0))
 		return false;
 
 	/* Matching the case 1.XX */
-	if (match_dot_second(payload)) {
+	if (match_dot(payload, 1)) {
 		/* Can't have two dots in a row */
-		if (!match_digit_third(payload))
+		if (!match_digit(payload, 2))
 			return false;
 
 		/* We can have either two digits, e.g. 1.45 */
-		if (match_digit_last(payload))
+		if (match_digit(payload, 3))
 			return true;
 		/* Or a another dot, e.g. 1.1. */
-		if (match_dot_last(payload))
+		if (match_dot(payload, 3))
 			return true;
 		return false;
 	} 
 	
 	/* Not a dot so must be a digit, e.g. 11XX */
-	if (!match_digit_second(payload)) {
+	if (!match_digit(payload, 1)) {
 		return false;
 	}
 
 	/* If the third character is a dot, then we need a digit as the last
 	 * e.g. 10.4 */
-	if (match_dot_third(payload)) {
-		if (!match_digit_last(payload))
+	if (match_dot(payload, 2)) {
+		if (!match_digit(payload, 3))
 			return false;
 		return true;
 	} 
 
 	/* Third character must be a digit, then */
-	if (!match_digit_third(payload))
+	if (!match_digit(payload, 2))
 		return false;
 
 	/* If we've got three digits, we must end on a dot - e.g. 192. */
-	if (match_dot_last(payload))
+	if (match_dot(payload, 3))
 		return true;
 
 	return false;
@@ -228,6 +124,11 @@ static inline bool match_whois(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	}
 	if (match_md5_option(data->payload[1]))
 		return true;
+
+	/* With extended payload capture, we can also recognise any query 
+	 * that is a single line of text, as described in RFC 3912 */
+	if (match_text_line(data, 0) || match_text_line(data, 1))
+		return true;
 	return false;
 }
 
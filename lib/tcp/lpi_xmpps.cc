@@ -91,12 +91,16 @@ static inline bool match_xmpps(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t xmpps_ports[] = { 5228, 8883, 0 };
+
 static lpi_module_t lpi_xmpps = {
 	LPI_PROTO_XMPPS,
 	LPI_CATEGORY_CHAT,
 	"XMPPS",
 	10, 
-	match_xmpps
+	match_xmpps,
+	LPI_PORTS_REQUIRED,
+	xmpps_ports
 };
 
 void register_xmpps(LPIModuleMap *mod_map) {
@@ -50,12 +50,16 @@ static inline bool match_xymon(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t xymon_ports[] = { 1984, 0 };
+
 static lpi_module_t lpi_xymon = {
 	LPI_PROTO_XYMON,
 	LPI_CATEGORY_MONITORING,
 	"Xymon",
 	6,
-	match_xymon
+	match_xymon,
+	LPI_PORTS_REQUIRED,
+	xymon_ports
 };
 
 void register_xymon(LPIModuleMap *mod_map) {
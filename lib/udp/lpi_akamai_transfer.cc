@@ -71,12 +71,16 @@ static inline bool match_akamai_transfer(lpi_data_t *data, lpi_module_t *mod UNU
 	return false;
 }
 
+static const uint16_t akamai_transfer_ports[] = { 1485, 0 };
+
 static lpi_module_t lpi_akamai_transfer = {
 	LPI_PROTO_UDP_AKAMAI_TRANSFER,
 	LPI_CATEGORY_CDN,
 	"AkamaiTransfer",
 	15,
-	match_akamai_transfer
+	match_akamai_transfer,
+	LPI_PORTS_REQUIRED,
+	akamai_transfer_ports
 };
 
 void register_akamai_transfer(LPIModuleMap *mod_map) {
@@ -110,12 +110,16 @@ static inline bool match_apple_facetime_init(lpi_data_t *data, lpi_module_t *mod
 	return false;
 }
 
+static const uint16_t apple_facetime_init_ports[] = { 16384, 16385, 16386, 16387, 16402, 16403, 16404, 16405, 16406, 16407, 16408, 16409, 16410, 0 };
+
 static lpi_module_t lpi_apple_facetime_init = {
 	LPI_PROTO_UDP_APPLE_FACETIME_INIT,
 	LPI_CATEGORY_NAT,	// Unsure about this one...
 	"AppleFacetimeInit",
 	16,
-	match_apple_facetime_init
+	match_apple_facetime_init,
+	LPI_PORTS_REQUIRED,
+	apple_facetime_init_ports
 };
 
 void register_apple_facetime_init(LPIModuleMap *mod_map) {
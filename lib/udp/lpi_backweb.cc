@@ -47,12 +47,16 @@ static inline bool match_backweb(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t backweb_ports[] = { 370, 0 };
+
 static lpi_module_t lpi_backweb = {
 	LPI_PROTO_UDP_BACKWEB,
 	LPI_CATEGORY_SECURITY,
 	"BackWeb",
 	5,
-	match_backweb
+	match_backweb,
+	LPI_PORTS_REQUIRED,
+	backweb_ports
 };
 
 void register_backweb(LPIModuleMap *mod_map) {
@@ -47,12 +47,16 @@ static inline bool match_canon_mfnp(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t canon_mfnp_ports[] = { 8610, 0 };
+
 static lpi_module_t lpi_canon_mfnp = {
 	LPI_PROTO_UDP_MFNP,
 	LPI_CATEGORY_PRINTING,
 	"Canon_MFNP",
 	8,
-	match_canon_mfnp
+	match_canon_mfnp,
+	LPI_PORTS_REQUIRED,
+	canon_mfnp_ports
 };
 
 void register_canon_mfnp(LPIModuleMap *mod_map) {
@@ -66,12 +66,16 @@ static inline bool match_cisco_ipsec(lpi_data_t *data, lpi_module_t *mod UNUSED)
 
 }
 
+static const uint16_t cisco_ipsec_ports[] = { 10000, 0 };
+
 static lpi_module_t lpi_cisco_ipsec = {
 	LPI_PROTO_UDP_CISCO_VPN,
 	LPI_CATEGORY_TUNNELLING,
 	"Cisco_VPN_UDP",
 	8,
-	match_cisco_ipsec
+	match_cisco_ipsec,
+	LPI_PORTS_REQUIRED,
+	cisco_ipsec_ports
 };
 
 void register_cisco_ipsec(LPIModuleMap *mod_map) {
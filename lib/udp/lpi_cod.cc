@@ -160,12 +160,25 @@ static inline bool match_callofduty(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+/* Every rule above needs one of these lengths in at least one direction */
+static const lpi_length_range_t callofduty_lengths[] = {
+	LPI_LEN_RANGE(13, 19),
+	LPI_LEN(45),
+	LPI_LEN(53),
+	LPI_LEN(74),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_callofduty = {
 	LPI_PROTO_UDP_COD,
 	LPI_CATEGORY_GAMING,
 	"Call_of_Duty",
 	6,	/* Must be lower priority than XLSP */
-	match_callofduty
+	match_callofduty,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	NULL,
+	{ callofduty_lengths, NULL }
 };
 
 void register_callofduty(LPIModuleMap *mod_map) {
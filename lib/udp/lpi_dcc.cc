@@ -43,7 +43,7 @@ static inline bool match_dcc_length(uint32_t payload, uint32_t len) {
 
 	uint32_t hdr_len;
 
-	hdr_len = (ntohl(payload)) >> 16;
+	hdr_len = PAYLOAD_FIELD16(payload, 0);
 
 	if (hdr_len == len)
 		return true;
@@ -59,7 +59,7 @@ static inline bool match_dcc_udp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 		return false;
 
 	/* Byte 3 must match */
-	if ((ntohl(data->payload[0]) & 0xff00) != (ntohl(data->payload[1]) & 0xff00))
+	if (!SAMEBITS(data->payload[0], data->payload[1], 0x0000ff00))
 		return false;
 
 	if (MATCH(data->payload[0], ANY, ANY, ANY, 0x01)) {
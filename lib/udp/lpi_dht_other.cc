@@ -95,14 +95,14 @@ static inline bool match_vuze_dht_request(uint32_t payload, uint32_t len,
 
         if (check_msb) {
 
-                if ((ntohl(payload) & 0x80000000) != 0x80000000)
+                if (!MATCHBITS(payload, 0x80000000, 0x80000000))
                         return false;
 
         } else {
                 /* Automatically return true if the MSB is set, regardless of
                  * request size */
 
-                if ((ntohl(payload) & 0x80000000) == 0x80000000)
+                if (MATCHBITS(payload, 0x80000000, 0x80000000))
                         return true;
         }
 
@@ -150,10 +150,10 @@ static inline bool match_vuze_dht_alt(lpi_data_t *data) {
          * that does suggest it is related to Vuze somehow. */
 
         if (data->payload_len[0] != 0 &&
-                        (ntohl(data->payload[0]) & 0x80000000) != 0x80000000)
+                        !MATCHBITS(data->payload[0], 0x80000000, 0x80000000))
                 return false;
         if (data->payload_len[1] != 0 &&
-                        (ntohl(data->payload[1]) & 0x80000000) != 0x80000000)
+                        !MATCHBITS(data->payload[1], 0x80000000, 0x80000000))
                 return false;
 
         if (data->payload_len[0] == 90 && data->payload_len[1] == 79)
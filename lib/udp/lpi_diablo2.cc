@@ -64,12 +64,16 @@ static inline bool match_diablo2(lpi_data_t *data, lpi_module_t *mod UNUSED) {
         return true;
 }
 
+static const uint16_t diablo2_ports[] = { 6112, 0 };
+
 static lpi_module_t lpi_diablo2 = {
 	LPI_PROTO_UDP_DIABLO2,
 	LPI_CATEGORY_GAMING,
 	"Diablo2",
 	3,
-	match_diablo2
+	match_diablo2,
+	LPI_PORTS_REQUIRED,
+	diablo2_ports
 };
 
 void register_diablo2(LPIModuleMap *mod_map) {
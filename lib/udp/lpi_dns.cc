@@ -49,12 +49,16 @@ static inline bool match_dns_udp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t dns_udp_ports[] = { 53, 0 };
+
 static lpi_module_t lpi_dns_udp = {
 	LPI_PROTO_UDP_DNS,
 	LPI_CATEGORY_SERVICES,
 	"DNS",
 	10,	/* Not a high certainty */
-	match_dns_udp
+	match_dns_udp,
+	LPI_PORTS_REQUIRED,
+	dns_udp_ports
 };
 
 void register_dns_udp(LPIModuleMap *mod_map) {
@@ -66,12 +66,16 @@ static inline bool match_driveshare(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return true;
 }
 
+static const uint16_t driveshare_ports[] = { 8109, 0 };
+
 static lpi_module_t lpi_driveshare = {
 	LPI_PROTO_UDP_DRIVESHARE,
 	LPI_CATEGORY_FILES,
 	"DriveShare",
 	12,
-	match_driveshare
+	match_driveshare,
+	LPI_PORTS_REQUIRED,
+	driveshare_ports
 };
 
 void register_driveshare(LPIModuleMap *mod_map) {
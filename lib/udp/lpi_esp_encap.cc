@@ -59,12 +59,16 @@ static inline bool match_esp_encap(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t esp_encap_ports[] = { 4500, 0 };
+
 static lpi_module_t lpi_esp_encap = {
 	LPI_PROTO_UDP_ESP,
 	LPI_CATEGORY_TUNNELLING,
 	"ESP_UDP",
 	200,	/* This is a pretty terrible rule */
-	match_esp_encap
+	match_esp_encap,
+	LPI_PORTS_REQUIRED,
+	esp_encap_ports
 };
 
 void register_esp_encap(LPIModuleMap *mod_map) {
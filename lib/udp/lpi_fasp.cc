@@ -78,12 +78,16 @@ static inline bool match_fasp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t fasp_ports[] = { 33001, 0 };
+
 static lpi_module_t lpi_fasp = {
 	LPI_PROTO_UDP_FASP,
 	LPI_CATEGORY_FILES,
 	"FASP",
 	16,
-	match_fasp
+	match_fasp,
+	LPI_PORTS_REQUIRED,
+	fasp_ports
 };
 
 void register_fasp(LPIModuleMap *mod_map) {
@@ -241,12 +241,33 @@ static inline bool match_gnutella_udp(lpi_data_t *data, lpi_module_t *mod UNUSED
 	return false;
 }
 
+/* Every rule above needs one of these lengths in at least one direction */
+static const lpi_length_range_t gnutella_udp_lengths[] = {
+	LPI_LEN(23),
+	LPI_LEN_RANGE(28, 29),
+	LPI_LEN_RANGE(31, 35),
+	LPI_LEN(38),
+	LPI_LEN(55),
+	LPI_LEN(67),
+	LPI_LEN_RANGE(72, 73),
+	LPI_LEN(81),
+	LPI_LEN(86),
+	LPI_LEN(96),
+	LPI_LEN(193),
+	LPI_LEN(727),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_gnutella_udp = {
 	LPI_PROTO_UDP_GNUTELLA,
 	LPI_CATEGORY_P2P,
 	"Gnutella_UDP",
 	10,	/* Rules are pretty dodgy so make this low priority */
-	match_gnutella_udp
+	match_gnutella_udp,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	NULL,
+	{ gnutella_udp_lengths, NULL }
 };
 
 void register_gnutella_udp(LPIModuleMap *mod_map) {
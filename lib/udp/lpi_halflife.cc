@@ -98,12 +98,26 @@ static inline bool match_halflife(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+/* Every rule above needs one of these lengths in at least one direction */
+static const lpi_length_range_t halflife_lengths[] = {
+	LPI_LEN(9),
+	LPI_LEN_RANGE(16, 17),
+	LPI_LEN(20),
+	LPI_LEN(65),
+	LPI_LEN(87),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_halflife = {
 	LPI_PROTO_UDP_HL,
 	LPI_CATEGORY_GAMING,
 	"HalfLife",
 	3,
-	match_halflife
+	match_halflife,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	NULL,
+	{ halflife_lengths, NULL }
 };
 
 void register_halflife(LPIModuleMap *mod_map) {
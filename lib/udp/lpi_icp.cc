@@ -40,7 +40,7 @@ static inline bool match_icp_query(uint32_t payload, uint32_t len) {
 
         uint32_t stated_len = 0;
 
-        stated_len = ntohl(payload) & 0xffff;
+        stated_len = PAYLOAD_FIELD16(payload, 2);
         if (stated_len != len)
                 return false;
 	
@@ -56,7 +56,7 @@ static inline bool match_icp_response(uint32_t payload, uint32_t len) {
 
         uint32_t stated_len = 0;
 
-        stated_len = ntohl(payload) & 0xffff;
+        stated_len = PAYLOAD_FIELD16(payload, 2);
         if (stated_len != len)
                 return false;
 	
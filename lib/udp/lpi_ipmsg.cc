@@ -58,12 +58,16 @@ static inline bool match_ipmsg(lpi_data_t *data, lpi_module_t *mod UNUSED) {
         return false;
 }
 
+static const uint16_t ipmsg_ports[] = { 2425, 0 };
+
 static lpi_module_t lpi_ipmsg = {
 	LPI_PROTO_UDP_IPMSG,
 	LPI_CATEGORY_CHAT,
 	"IPMsg",
 	5,
-	match_ipmsg
+	match_ipmsg,
+	LPI_PORTS_REQUIRED,
+	ipmsg_ports
 };
 
 void register_ipmsg(LPIModuleMap *mod_map) {
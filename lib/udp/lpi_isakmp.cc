@@ -63,12 +63,16 @@ static inline bool match_isakmp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t isakmp_ports[] = { 500, 0 };
+
 static lpi_module_t lpi_isakmp = {
 	LPI_PROTO_UDP_ISAKMP,
 	LPI_CATEGORY_KEY_EXCHANGE,
 	"ISAKMP",
 	6,
-	match_isakmp
+	match_isakmp,
+	LPI_PORTS_REQUIRED,
+	isakmp_ports
 };
 
 void register_isakmp(LPIModuleMap *mod_map) {
@@ -45,12 +45,16 @@ static inline bool match_kaspersky_udp(lpi_data_t *data,
 	return match_kaspersky(data);
 }
 
+static const uint16_t kaspersky_ports[] = { 2001, 0 };
+
 static lpi_module_t lpi_kaspersky = {
 	LPI_PROTO_UDP_KASPERSKY,
 	LPI_CATEGORY_SECURITY,
 	"Kaspersky_UDP",
 	3,
-	match_kaspersky_udp
+	match_kaspersky_udp,
+	LPI_PORTS_REQUIRED,
+	kaspersky_ports
 };
 
 void register_kaspersky_udp(LPIModuleMap *mod_map) {
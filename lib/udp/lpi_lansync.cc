@@ -69,12 +69,16 @@ static inline bool match_lansync_udp(lpi_data_t *data,
 	return false;
 }
 
+static const uint16_t lansync_udp_ports[] = { 17500, 0 };
+
 static lpi_module_t lpi_lansync_udp = {
 	LPI_PROTO_UDP_LANSYNC,
 	LPI_CATEGORY_BROADCAST,
 	"LanSync_UDP",
 	6,
-	match_lansync_udp
+	match_lansync_udp,
+	LPI_PORTS_REQUIRED,
+	lansync_udp_ports
 };
 
 void register_lansync_udp(LPIModuleMap *mod_map) {
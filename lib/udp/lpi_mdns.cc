@@ -69,12 +69,16 @@ static inline bool match_mdns(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t mdns_ports[] = { 5353, 0 };
+
 static lpi_module_t lpi_mdns = {
 	LPI_PROTO_UDP_MDNS,
 	LPI_CATEGORY_SERVICES,
 	"mDNS",
 	20,
-	match_mdns
+	match_mdns,
+	LPI_PORTS_REQUIRED,
+	mdns_ports
 };
 
 void register_mdns(LPIModuleMap *mod_map) {
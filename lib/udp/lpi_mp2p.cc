@@ -84,12 +84,16 @@ static inline bool match_mp2p_udp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t mp2p_udp_ports[] = { 41170, 0 };
+
 static lpi_module_t lpi_mp2p_udp = {
 	LPI_PROTO_UDP_MP2P,
 	LPI_CATEGORY_P2P,
 	"MP2P_UDP",
 	4,
-	match_mp2p_udp
+	match_mp2p_udp,
+	LPI_PORTS_REQUIRED,
+	mp2p_udp_ports
 };
 
 void register_mp2p_udp(LPIModuleMap *mod_map) {
@@ -64,12 +64,16 @@ static inline bool match_msoffice_mac(lpi_data_t *data,
 	return false;
 }
 
+static const uint16_t msoffice_mac_ports[] = { 2223, 0 };
+
 static lpi_module_t lpi_msoffice_mac = {
 	LPI_PROTO_UDP_MSOFFICE_MAC,
 	LPI_CATEGORY_BROADCAST,
 	"MSOffice_Mac",
 	10,
-	match_msoffice_mac
+	match_msoffice_mac,
+	LPI_PORTS_REQUIRED,
+	msoffice_mac_ports
 };
 
 void register_msoffice_mac(LPIModuleMap *mod_map) {
@@ -75,12 +75,20 @@ static inline bool match_mystery_05(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const lpi_signature_t mystery_05_sigs[] = {
+	LPI_SIG_LEN(0x05, 0x03, 0xff, 0xff, 6, 6),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_05 = {
 	LPI_PROTO_UDP_MYSTERY_05,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_05",
 	250,
-	match_mystery_05
+	match_mystery_05,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_05_sigs
 };
 
 void register_mystery_05(LPIModuleMap *mod_map) {
@@ -63,12 +63,20 @@ static inline bool match_mystery_0660(lpi_data_t *data, lpi_module_t *mod UNUSED
 	return false;
 }
 
+static const lpi_signature_t mystery_0660_sigs[] = {
+	LPI_SIG_LEN(0x06, 0x60, 0x00, 0x00, 15, 15),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_0660 = {
 	LPI_PROTO_UDP_MYSTERY_0660,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_0660",
 	250,
-	match_mystery_0660
+	match_mystery_0660,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_0660_sigs
 };
 
 void register_mystery_0660(LPIModuleMap *mod_map) {
@@ -87,12 +87,21 @@ static inline bool match_mystery_0d(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const lpi_signature_t mystery_0d_sigs[] = {
+	LPI_SIG_LEN(0x0d, 0x00, 0x00, 0x00, 1, 1),
+	LPI_SIG_LEN(0x0a, ANY, ANY, ANY, 25, 25),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_0d = {
 	LPI_PROTO_UDP_MYSTERY_0D,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_0D",
 	250,
-	match_mystery_0d
+	match_mystery_0d,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_0d_sigs
 };
 
 void register_mystery_0d(LPIModuleMap *mod_map) {
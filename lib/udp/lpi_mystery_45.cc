@@ -75,12 +75,21 @@ static inline bool match_mystery_45(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const lpi_signature_t mystery_45_sigs[] = {
+	LPI_SIG_LEN(0x00, 0x00, 0x00, 0x45, 33, 33),
+	LPI_SIG_LEN(0x00, 0x00, 0x00, 0x45, 69, 69),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_45 = {
 	LPI_PROTO_UDP_MYSTERY_45,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_45",
 	250,
-	match_mystery_45
+	match_mystery_45,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_45_sigs
 };
 
 void register_mystery_45(LPIModuleMap *mod_map) {
@@ -88,12 +88,25 @@ static inline bool match_mystery_e9(lpi_data_t *data, lpi_module_t *mod UNUSED)
 
 }
 
+static const lpi_signature_t mystery_e9_sigs[] = {
+	LPI_SIG_LEN(0xe9, 0x82, ANY, ANY, 28, 28),
+	LPI_SIG_LEN(0xe9, 0x82, ANY, ANY, 58, 58),
+	LPI_SIG_LEN(0xe9, 0x83, ANY, ANY, 23, 23),
+	LPI_SIG_LEN(0xe9, 0x83, ANY, ANY, 28, 28),
+	LPI_SIG_LEN(0xe9, 0x83, ANY, ANY, 46, 46),
+	LPI_SIG_LEN(0xe9, 0x60, ANY, ANY, 34, 34),
+	LPI_SIG_END
+};
+
 static lpi_module_t lpi_mystery_e9 = {
 	LPI_PROTO_UDP_MYSTERY_E9,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_E9",
 	250,
-	match_mystery_e9
+	match_mystery_e9,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	mystery_e9_sigs
 };
 
 void register_mystery_e9(LPIModuleMap *mod_map) {
@@ -67,12 +67,16 @@ static inline bool match_mystery_qq(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t mystery_qq_ports[] = { 3658, 0 };
+
 static lpi_module_t lpi_mystery_qq = {
 	LPI_PROTO_UDP_MYSTERY_QQ,
 	LPI_CATEGORY_NO_CATEGORY,
 	"Mystery_QQ",
 	2,
-	match_mystery_qq
+	match_mystery_qq,
+	LPI_PORTS_REQUIRED,
+	mystery_qq_ports
 };
 
 void register_mystery_qq(LPIModuleMap *mod_map) {
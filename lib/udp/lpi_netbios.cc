@@ -160,12 +160,16 @@ static inline bool match_netbios_udp(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t netbios_udp_ports[] = { 137, 0 };
+
 static lpi_module_t lpi_netbios_udp = {
 	LPI_PROTO_UDP_NETBIOS,
 	LPI_CATEGORY_SERVICES,
 	"NetBIOS_UDP",
 	5,
-	match_netbios_udp
+	match_netbios_udp,
+	LPI_PORTS_PREFERRED,
+	netbios_udp_ports
 };
 
 void register_netbios_udp(LPIModuleMap *mod_map) {
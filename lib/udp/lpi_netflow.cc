@@ -60,12 +60,16 @@ static inline bool match_netflow(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t netflow_ports[] = { 9996, 0 };
+
 static lpi_module_t lpi_netflow = {
 	LPI_PROTO_UDP_NETFLOW,
 	LPI_CATEGORY_MONITORING,
 	"NetFlow",
 	14,
-	match_netflow
+	match_netflow,
+	LPI_PORTS_REQUIRED,
+	netflow_ports
 };
 
 void register_netflow(LPIModuleMap *mod_map) {
@@ -120,12 +120,16 @@ static inline bool match_ntp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t ntp_ports[] = { 123, 0 };
+
 static lpi_module_t lpi_ntp = {
 	LPI_PROTO_UDP_NTP,
 	LPI_CATEGORY_SERVICES,
 	"NTP",
 	2,
-	match_ntp
+	match_ntp,
+	LPI_PORTS_REQUIRED,
+	ntp_ports
 };
 
 void register_ntp(LPIModuleMap *mod_map) {
@@ -56,12 +56,16 @@ static inline bool match_opaserv(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t opaserv_ports[] = { 137, 0 };
+
 static lpi_module_t lpi_opaserv = {
 	LPI_PROTO_UDP_OPASERV,
 	LPI_CATEGORY_MALWARE,
 	"Opaserv",
 	10,
-	match_opaserv
+	match_opaserv,
+	LPI_PORTS_REQUIRED,
+	opaserv_ports
 };
 
 void register_opaserv(LPIModuleMap *mod_map) {
@@ -77,12 +77,16 @@ static inline bool match_openvpn_udp(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t openvpn_udp_ports[] = { 1194, 0 };
+
 static lpi_module_t lpi_openvpn_udp = {
 	LPI_PROTO_UDP_OPENVPN,
 	LPI_CATEGORY_TUNNELLING,
 	"OpenVPN_UDP",
 	12,
-	match_openvpn_udp
+	match_openvpn_udp,
+	LPI_PORTS_REQUIRED,
+	openvpn_udp_ports
 };
 
 void register_openvpn_udp(LPIModuleMap *mod_map) {
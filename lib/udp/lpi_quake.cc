@@ -93,12 +93,31 @@ static inline bool match_quake(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+/* A 4 byte ping or 16 byte request, and the response to it */
+static const lpi_length_range_t quake_request_lengths[] = {
+	LPI_LEN(4),
+	LPI_LEN(16),
+	LPI_LEN_END
+};
+
+static const lpi_length_range_t quake_response_lengths[] = {
+	LPI_LEN(0),
+	LPI_LEN(14),
+	LPI_LEN(33),
+	LPI_LEN_RANGE(51, 54),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_quake = {
 	LPI_PROTO_UDP_QUAKE,
 	LPI_CATEGORY_GAMING,
 	"Quake",
 	6,
-	match_quake
+	match_quake,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	NULL,
+	{ quake_request_lengths, quake_response_lengths }
 };
 
 void register_quake(LPIModuleMap *mod_map) {
@@ -81,8 +81,7 @@ static inline bool match_radius(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	//	return false;
 
 	/* Second byte is the ID field, which must match for both payloads */
-	if ((ntohl(data->payload[0]) & 0xff0000) != 
-			(ntohl(data->payload[1]) & 0xff0000))
+	if (!SAMEBITS(data->payload[0], data->payload[1], 0x00ff0000))
 		return false;
 
 	if (match_radius_request(data->payload[0], data->payload_len[0])) {
@@ -85,10 +85,8 @@ static inline bool match_rtp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 			return true;
 		if (match_rtp_payload(data->payload[1], data->payload_len[1], 
 				data->payload_len[0])) {
-			uint32_t a = ntohl(data->payload[0]) & 0xffff0000;
-			uint32_t b = ntohl(data->payload[1]) & 0xffff0000;
-
-			if (a != b)
+			if (!SAMEBITS(data->payload[0], data->payload[1],
+					0xffff0000))
 				return false;
 			return true;
 		}
@@ -106,12 +104,22 @@ static inline bool match_rtp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+/* At least one direction must be long enough for an RTP packet */
+static const lpi_length_range_t rtp_lengths[] = {
+	LPI_LEN_MIN(32),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_rtp = {
 	LPI_PROTO_UDP_RTP,
 	LPI_CATEGORY_VOIP,
 	"RTP",
 	13,
-	match_rtp
+	match_rtp,
+	LPI_PORTS_AGNOSTIC,
+	NULL,
+	NULL,
+	{ rtp_lengths, NULL }
 };
 
 void register_rtp(LPIModuleMap *mod_map) {
@@ -44,14 +44,10 @@ static inline bool match_skype_rule1(lpi_data_t *data) {
         /* The third byte is always 0x02 in Skype UDP traffic - if we have
          * payload in both directions we can probably match on that alone */
 
-	uint32_t payload0 = ntohl(data->payload[0]);
-	uint32_t payload1 = ntohl(data->payload[1]);
-
-
         if (data->payload_len[0] > 0 && data->payload_len[1] > 0) {
-                if ((payload0 & 0x0000ff00) != 0x00000200)
+                if (!MATCHBITS(data->payload[0], 0x0000ff00, 0x00000200))
                         return false;
-                if ((payload1 & 0x0000ff00) != 0x00000200)
+                if (!MATCHBITS(data->payload[1], 0x0000ff00, 0x00000200))
                         return false;
                 return true;
         }
@@ -61,11 +57,11 @@ static inline bool match_skype_rule1(lpi_data_t *data) {
          * and filter on packet size too */
 
         if (data->payload_len[0] >= 18 && data->payload_len[0] <= 137 ) {
-                if ((payload0 & 0x0000ff00) == 0x00000200)
+                if (MATCHBITS(data->payload[0], 0x0000ff00, 0x00000200))
                         return true;
         }
         if (data->payload_len[1] >= 18 && data->payload_len[1] <= 137 ) {
-                if ((payload1 & 0x0000ff00) == 0x00000200)
+                if (MATCHBITS(data->payload[1], 0x0000ff00, 0x00000200))
                         return true;
         }
 
@@ -77,7 +73,7 @@ static inline bool match_skype_U1(uint32_t payload, uint32_t len) {
 
         if (len < 18)
                 return false;
-        if ((ntohl(payload) & 0x0000ff00) == 0x00000200)
+        if (MATCHBITS(payload, 0x0000ff00, 0x00000200))
                 return true;
 
         return false;
@@ -88,9 +84,9 @@ static inline bool match_skype_U2(uint32_t payload, uint32_t len) {
 
         if (len != 11)
                 return false;
-        if ((ntohl(payload) & 0x00000f00) == 0x00000500)
+        if (MATCHBITS(payload, 0x00000f00, 0x00000500))
                 return true;
-        if ((ntohl(payload) & 0x00000f00) == 0x00000700)
+        if (MATCHBITS(payload, 0x00000f00, 0x00000700))
                 return true;
         return false;
 }
@@ -113,8 +109,7 @@ static inline bool match_skype_rule2(lpi_data_t *data) {
          * The length of U1 is always between 18 and 31 bytes.
          */
 
-        if ((ntohl(data->payload[0]) & 0xffff0000) != 
-			(ntohl(data->payload[1]) & 0xffff0000))
+        if (!SAMEBITS(data->payload[0], data->payload[1], 0xffff0000))
                 return false;
 
         if (match_skype_U1(data->payload[0], data->payload_len[0])) {
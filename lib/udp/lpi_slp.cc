@@ -88,12 +88,16 @@ static inline bool match_slp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t slp_ports[] = { 427, 0 };
+
 static lpi_module_t lpi_slp = {
 	LPI_PROTO_UDP_SLP,
 	LPI_CATEGORY_SERVICES,
 	"SLP",
 	5,
-	match_slp
+	match_slp,
+	LPI_PORTS_REQUIRED,
+	slp_ports
 };
 
 void register_slp(LPIModuleMap *mod_map) {
@@ -50,12 +50,16 @@ static inline bool match_spotify_bcast(lpi_data_t *data,
 	return true;
 }
 
+static const uint16_t spotify_bcast_ports[] = { 57621, 0 };
+
 static lpi_module_t lpi_spotify_bcast = {
 	LPI_PROTO_UDP_SPOTIFY_BROADCAST,
 	LPI_CATEGORY_BROADCAST,
 	"SpotifyBroadcast",
 	14,
-	match_spotify_bcast
+	match_spotify_bcast,
+	LPI_PORTS_REQUIRED,
+	spotify_bcast_ports
 };
 
 void register_spotify_bcast(LPIModuleMap *mod_map) {
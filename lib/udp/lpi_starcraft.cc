@@ -74,12 +74,16 @@ static inline bool match_starcraft(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 
 }
 
+static const uint16_t starcraft_ports[] = { 6112, 0 };
+
 static lpi_module_t lpi_starcraft = {
 	LPI_PROTO_UDP_STARCRAFT,
 	LPI_CATEGORY_GAMING,
 	"Starcraft",
 	4,
-	match_starcraft
+	match_starcraft,
+	LPI_PORTS_REQUIRED,
+	starcraft_ports
 };
 
 void register_starcraft(LPIModuleMap *mod_map) {
@@ -93,12 +93,16 @@ static inline bool match_steam_localbroadcast(lpi_data_t *data,
 	return false;
 }
 
+static const uint16_t steam_localbroadcast_ports[] = { 10007, 10019, 0 };
+
 static lpi_module_t lpi_steam_localbroadcast = {
 	LPI_PROTO_UDP_STEAM_LOCALBROADCAST,
 	LPI_CATEGORY_BROADCAST,
 	"SteamLocalBroadcast",
 	16,
-	match_steam_localbroadcast
+	match_steam_localbroadcast,
+	LPI_PORTS_REQUIRED,
+	steam_localbroadcast_ports
 };
 
 void register_steam_localbroadcast(LPIModuleMap *mod_map) {
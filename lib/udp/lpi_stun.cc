@@ -44,7 +44,7 @@ static bool match_stun_payload(uint32_t payload, uint32_t len) {
         /* Bytes 3 and 4 are the Message Length - the STUN header 
          *
          * XXX Byte ordering is a cock! */
-        if ((ntohl(payload) & 0x0000ffff) != len - 20)
+        if (PAYLOAD_FIELD16(payload, 2) != len - 20)
                 return false;
 
         if (MATCH(payload, 0x00, 0x01, ANY, ANY))
@@ -69,12 +69,16 @@ static inline bool match_syslog(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t syslog_ports[] = { 514, 0 };
+
 static lpi_module_t lpi_syslog = {
 	LPI_PROTO_UDP_SYSLOG,
 	LPI_CATEGORY_LOGGING,
 	"Syslog",
 	6,
-	match_syslog
+	match_syslog,
+	LPI_PORTS_REQUIRED,
+	syslog_ports
 };
 
 void register_syslog(LPIModuleMap *mod_map) {
@@ -116,12 +116,16 @@ static inline bool match_tftp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t tftp_ports[] = { 69, 0 };
+
 static lpi_module_t lpi_tftp = {
 	LPI_PROTO_UDP_TFTP,
 	LPI_CATEGORY_FILES,
 	"TFTP",
 	5,
-	match_tftp
+	match_tftp,
+	LPI_PORTS_PREFERRED,
+	tftp_ports
 };
 
 void register_tftp(LPIModuleMap *mod_map) {
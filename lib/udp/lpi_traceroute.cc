@@ -109,12 +109,16 @@ static inline bool match_traceroute(lpi_data_t *data, lpi_module_t *mod UNUSED)
 	return false;
 }
 
+static const uint16_t traceroute_ports[] = { 33435, 0 };
+
 static lpi_module_t lpi_traceroute = {
 	LPI_PROTO_UDP_TRACEROUTE,
 	LPI_CATEGORY_MONITORING,
 	"Traceroute_UDP",
 	2,
-	match_traceroute
+	match_traceroute,
+	LPI_PORTS_PREFERRED,
+	traceroute_ports
 };
 
 void register_traceroute(LPIModuleMap *mod_map) {
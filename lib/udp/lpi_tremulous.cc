@@ -89,12 +89,16 @@ static inline bool match_tremulous(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 	return false;
 }
 
+static const uint16_t tremulous_ports[] = { 30710, 30711, 0 };
+
 static lpi_module_t lpi_tremulous = {
 	LPI_PROTO_UDP_TREMULOUS,
 	LPI_CATEGORY_GAMING,
 	"Tremulous",
 	7,
-	match_tremulous
+	match_tremulous,
+	LPI_PORTS_REQUIRED,
+	tremulous_ports
 };
 
 void register_tremulous(LPIModuleMap *mod_map) {
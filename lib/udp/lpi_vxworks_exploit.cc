@@ -63,12 +63,16 @@ static inline bool match_vxworks_exploit(lpi_data_t *data, lpi_module_t *mod UNU
 	return false;
 }
 
+static const uint16_t vxworks_exploit_ports[] = { 17185, 0 };
+
 static lpi_module_t lpi_vxworks_exploit = {
 	LPI_PROTO_UDP_VXWORKS_EXPLOIT,
 	LPI_CATEGORY_MALWARE,
 	"VxWorks_Exploit",
 	14,
-	match_vxworks_exploit
+	match_vxworks_exploit,
+	LPI_PORTS_REQUIRED,
+	vxworks_exploit_ports
 };
 
 void register_vxworks_exploit(LPIModuleMap *mod_map) {
@@ -235,12 +235,46 @@ static inline bool match_xlsp(lpi_data_t *data, lpi_module_t *mod UNUSED) {
 }
 
 
+static const uint16_t xlsp_ports[] = { 3074, 0 };
+
+/* The payload lengths in both directions must come from this list */
+static const lpi_length_range_t xlsp_lengths[] = {
+	LPI_LEN(0),
+	LPI_LEN(4),
+	LPI_LEN(14),
+	LPI_LEN_RANGE(16, 17),
+	LPI_LEN(24),
+	LPI_LEN(26),
+	LPI_LEN(29),
+	LPI_LEN(32),
+	LPI_LEN(43),
+	LPI_LEN(50),
+	LPI_LEN(75),
+	LPI_LEN_RANGE(82, 83),
+	LPI_LEN_RANGE(90, 91),
+	LPI_LEN(120),
+	LPI_LEN(122),
+	LPI_LEN_RANGE(138, 139),
+	LPI_LEN(156),
+	LPI_LEN(172),
+	LPI_LEN_RANGE(286, 287),
+	LPI_LEN(1003),
+	LPI_LEN_RANGE(1010, 1011),
+	LPI_LEN_RANGE(1026, 1027),
+	LPI_LEN(1336),
+	LPI_LEN_END
+};
+
 static lpi_module_t lpi_xlsp = {
 	LPI_PROTO_UDP_XLSP,
 	LPI_CATEGORY_GAMING,
 	"XboxLive_UDP",
 	6,
-	match_xlsp
+	match_xlsp,
+	LPI_PORTS_PREFERRED,
+	xlsp_ports,
+	NULL,
+	{ xlsp_lengths, xlsp_lengths }
 };
 
 void register_xlsp(LPIModuleMap *mod_map) {
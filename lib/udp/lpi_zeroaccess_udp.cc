@@ -122,12 +122,16 @@ static inline bool match_zeroaccess_udp(lpi_data_t *data, lpi_module_t *mod UNUS
 	return false;
 }
 
+static const uint16_t zeroaccess_udp_ports[] = { 16464, 16465, 16470, 16471, 0 };
+
 static lpi_module_t lpi_zeroaccess_udp = {
 	LPI_PROTO_UDP_ZEROACCESS,
 	LPI_CATEGORY_MALWARE,
 	"ZeroAccess_UDP",
 	40,
-	match_zeroaccess_udp
+	match_zeroaccess_udp,
+	LPI_PORTS_REQUIRED,
+	zeroaccess_udp_ports
 };
 
 void register_zeroaccess_udp(LPIModuleMap *mod_map) {
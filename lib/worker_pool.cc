@@ -0,0 +1,390 @@
+/*
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Worker pool for classifying flows in parallel.
+ *
+ * Trying to run each module in a separate thread turned out to be much
+ * slower than just running them one after another, so the parallelism here
+ * is at the flow level instead: the thread that is reading packets submits
+ * whole flows to the pool and picks up the results later on.
+ *
+ * Each worker has two rings. The request ring is filled by the submitting
+ * thread and emptied by the worker, although an idle worker may also steal
+ * requests from the request rings of other workers. The result ring is
+ * filled by the worker and emptied by lpi_pool_complete(). There is only
+ * ever one producer for each ring, so the tail index can be updated
+ * without any locking. Consumers claim entries by advancing the head index
+ * with a compare-and-swap, which is what allows stealing.
+ *
+ * Workers only sleep when every request ring is empty.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "libprotoident.h"
+
+/* Number of entries in each ring - must be a power of two */
+#define LPI_POOL_RING_SIZE 4096
+#define LPI_POOL_RING_MASK (LPI_POOL_RING_SIZE - 1)
+
+#define LPI_CACHE_LINE 64
+
+typedef struct lpi_pool_ring {
+	/* Advanced by whoever removes an entry from the ring */
+	uint32_t head;
+	char pad1[LPI_CACHE_LINE - sizeof(uint32_t)];
+
+	/* Only ever advanced by the producer */
+	uint32_t tail;
+	char pad2[LPI_CACHE_LINE - sizeof(uint32_t)];
+
+	lpi_pool_result_t slots[LPI_POOL_RING_SIZE];
+} LPIPoolRing;
+
+typedef struct lpi_pool_worker {
+	LPIPoolRing requests;
+	LPIPoolRing results;
+
+	/* Only updated by the worker itself */
+	uint64_t classified;
+	uint64_t stolen;
+
+	lpi_pool_t *pool;
+	int index;
+	pthread_t thread;
+	bool started;
+} LPIPoolWorker;
+
+struct lpi_pool {
+	lpi_context_t *ctx;
+	int nthreads;
+	LPIPoolWorker *workers;
+
+	/* Only used by the thread that submits requests and collects
+	 * results */
+	int next_submit;
+	int next_collect;
+	uint64_t submitted;
+	uint64_t rejected;
+	uint64_t completed;
+
+	/* Shared between the submitting thread and the workers */
+	uint32_t queued;
+	uint32_t sleepers;
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+static bool ring_push(LPIPoolRing *ring, lpi_pool_result_t *entry) {
+
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	if (tail - head == LPI_POOL_RING_SIZE)
+		return false;
+
+	ring->slots[tail & LPI_POOL_RING_MASK] = *entry;
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+static bool ring_pop(LPIPoolRing *ring, lpi_pool_result_t *entry) {
+
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	uint32_t tail;
+
+	/* The producer can't reuse the slot at 'head' until head has moved
+	 * past it, so it is safe to copy the entry before we claim it. If
+	 * someone else claims it first, the CAS fails and we try again with
+	 * the new head */
+	for (;;) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head == tail)
+			return false;
+
+		*entry = ring->slots[head & LPI_POOL_RING_MASK];
+		if (__atomic_compare_exchange_n(&ring->head, &head, head + 1,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			return true;
+	}
+}
+
+static uint32_t ring_depth(LPIPoolRing *ring) {
+
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	return tail - head;
+}
+
+static bool steal_request(lpi_pool_t *pool, LPIPoolWorker *worker,
+		lpi_pool_result_t *req) {
+
+	int i;
+
+	for (i = 1; i < pool->nthreads; i++) {
+		LPIPoolWorker *victim = &pool->workers[
+				(worker->index + i) % pool->nthreads];
+
+		if (ring_pop(&victim->requests, req))
+			return true;
+	}
+	return false;
+}
+
+static void wait_for_work(lpi_pool_t *pool) {
+
+	pthread_mutex_lock(&pool->lock);
+	__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+
+	while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 &&
+			!__atomic_load_n(&pool->stop, __ATOMIC_SEQ_CST)) {
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	}
+
+	__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void *worker_thread(void *arg) {
+
+	LPIPoolWorker *worker = (LPIPoolWorker *)arg;
+	lpi_pool_t *pool = worker->pool;
+	lpi_pool_result_t req;
+
+	while (!__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+
+		if (ring_pop(&worker->requests, &req)) {
+			/* Got one from our own queue */
+		} else if (steal_request(pool, worker, &req)) {
+			__atomic_store_n(&worker->stolen, worker->stolen + 1,
+					__ATOMIC_RELAXED);
+		} else {
+			wait_for_work(pool);
+			continue;
+		}
+
+		__atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+
+		if (pool->ctx)
+			req.module = lpi_ctx_guess(pool->ctx, req.data);
+		else
+			req.module = lpi_guess_protocol(req.data);
+
+		/* If the caller isn't collecting results fast enough, we
+		 * have no choice but to wait for them */
+		while (!ring_push(&worker->results, &req)) {
+			if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE))
+				return NULL;
+			sched_yield();
+		}
+
+		__atomic_store_n(&worker->classified, worker->classified + 1,
+				__ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+static void stop_workers(lpi_pool_t *pool) {
+
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	__atomic_store_n(&pool->stop, true, __ATOMIC_SEQ_CST);
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->nthreads; i++) {
+		if (pool->workers[i].started)
+			pthread_join(pool->workers[i].thread, NULL);
+		pool->workers[i].started = false;
+	}
+}
+
+lpi_pool_t *lpi_pool_create_ctx(lpi_context_t *ctx, int nthreads) {
+
+	lpi_pool_t *pool;
+	void *mem = NULL;
+	int i;
+
+	if (nthreads <= 0) {
+		fprintf(stderr, "Invalid number of threads for LPI worker pool: %d\n", nthreads);
+		return NULL;
+	}
+
+	pool = (lpi_pool_t *)calloc(1, sizeof(lpi_pool_t));
+	if (pool == NULL) {
+		fprintf(stderr, "Unable to allocate memory for LPI worker pool\n");
+		return NULL;
+	}
+
+	if (posix_memalign(&mem, LPI_CACHE_LINE,
+				sizeof(LPIPoolWorker) * nthreads) != 0) {
+		fprintf(stderr, "Unable to allocate memory for LPI worker pool\n");
+		free(pool);
+		return NULL;
+	}
+	memset(mem, 0, sizeof(LPIPoolWorker) * nthreads);
+
+	pool->ctx = ctx;
+	pool->nthreads = nthreads;
+	pool->workers = (LPIPoolWorker *)mem;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		LPIPoolWorker *worker = &pool->workers[i];
+
+		worker->pool = pool;
+		worker->index = i;
+
+		if (pthread_create(&worker->thread, NULL, worker_thread,
+					worker) != 0) {
+			fprintf(stderr, "Unable to start LPI worker thread\n");
+			lpi_pool_destroy(pool);
+			return NULL;
+		}
+		worker->started = true;
+	}
+
+	return pool;
+}
+
+lpi_pool_t *lpi_pool_create(int nthreads) {
+
+	return lpi_pool_create_ctx(NULL, nthreads);
+}
+
+int lpi_pool_submit(lpi_pool_t *pool, lpi_data_t *data, void *user) {
+
+	lpi_pool_result_t req;
+	int i;
+
+	req.data = data;
+	req.user = user;
+	req.module = NULL;
+
+	/* Spread the requests across the workers, skipping any queues
+	 * that are already full */
+	for (i = 0; i < pool->nthreads; i++) {
+		int w = (pool->next_submit + i) % pool->nthreads;
+
+		if (!ring_push(&pool->workers[w].requests, &req))
+			continue;
+
+		pool->next_submit = (w + 1) % pool->nthreads;
+		pool->submitted ++;
+
+		__atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+			pthread_mutex_lock(&pool->lock);
+			pthread_cond_signal(&pool->cond);
+			pthread_mutex_unlock(&pool->lock);
+		}
+		return 0;
+	}
+
+	pool->rejected ++;
+	return -1;
+}
+
+int lpi_pool_complete(lpi_pool_t *pool, lpi_pool_result_t *results, int max) {
+
+	int count = 0;
+	int i;
+
+	for (i = 0; i < pool->nthreads && count < max; i++) {
+		LPIPoolWorker *worker = &pool->workers[
+				(pool->next_collect + i) % pool->nthreads];
+
+		while (count < max && ring_pop(&worker->results,
+					&results[count]))
+			count ++;
+	}
+
+	/* Start with the next worker along next time, so that one busy
+	 * worker can't starve the others */
+	pool->next_collect = (pool->next_collect + 1) % pool->nthreads;
+	pool->completed += count;
+	return count;
+}
+
+void lpi_pool_get_stats(lpi_pool_t *pool, lpi_pool_stats_t *stats,
+		lpi_pool_worker_stats_t *workers) {
+
+	int i;
+
+	memset(stats, 0, sizeof(lpi_pool_stats_t));
+	stats->nthreads = pool->nthreads;
+	stats->submitted = pool->submitted;
+	stats->rejected = pool->rejected;
+	stats->completed = pool->completed;
+
+	for (i = 0; i < pool->nthreads; i++) {
+		LPIPoolWorker *worker = &pool->workers[i];
+		uint32_t queued = ring_depth(&worker->requests);
+		uint32_t waiting = ring_depth(&worker->results);
+
+		stats->queue_depth += queued;
+		stats->results_waiting += waiting;
+
+		if (workers == NULL)
+			continue;
+		workers[i].classified = __atomic_load_n(&worker->classified,
+				__ATOMIC_RELAXED);
+		workers[i].stolen = __atomic_load_n(&worker->stolen,
+				__ATOMIC_RELAXED);
+		workers[i].queue_depth = queued;
+		workers[i].results_waiting = waiting;
+	}
+}
+
+void lpi_pool_destroy(lpi_pool_t *pool) {
+
+	if (pool == NULL)
+		return;
+
+	stop_workers(pool);
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->cond);
+	free(pool->workers);
+	free(pool);
+}
@@ -361,8 +361,10 @@ void per_packet(libtrace_packet_t *packet)
 	per_packet_flow(packet, ident, dir, ts);
 
 	/* Pass the packet into libprotoident so it can extract any info
-	 * it needs from this packet */
-	lpi_update_data(packet, &ident->lpi, dir);
+	 * it needs from this packet. There is no need to keep doing so once
+	 * the LPI data is complete */
+	if (!lpi_data_is_complete(&ident->lpi))
+		lpi_update_data(packet, &ident->lpi, dir);
 
 	/* Update TCP state for TCP flows. The TCP state determines how long
 	 * the flow can be idle before being expired by libflowmanager. For
@@ -385,7 +387,7 @@ static void cleanup_signal(int sig)
 static void usage(char *prog)
 {
 	printf("Usage details for %s\n\n", prog);
-	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] inputURI [inputURI ...]\n\n", prog);
+	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] [-I <file>] [-E <file>] [-D <list>] inputURI [inputURI ...]\n\n", prog);
 	printf("Options:\n");
 	printf("  -l <mac>     Determine direction based on <mac> representing the 'inside'\n");
 	printf("               portion of the network\n");
@@ -395,6 +397,10 @@ static void usage(char *prog)
 	printf("               direction\n");
 	printf("  -f <filter>  Ignore flows that do not match the given BPF filter\n");
 	printf("  -R           Ignore flows involving private RFC 1918 address space\n");
+	printf("  -I <file>    Only try the protocols and categories listed in <file>\n");
+	printf("  -E <file>    Do not try the protocols and categories listed in <file>\n");
+	printf("  -D <list>    Classify the traffic inside the listed tunnels\n");
+	printf("               (gre, ipip, vxlan, teredo) rather than the tunnels\n");
 	exit(0);
 }
 
@@ -413,6 +419,9 @@ int main(int argc, char *argv[])
 	char *filterstring = NULL;
 	int dir;
 	bool ignore_rfc1918 = false;
+	char *proto_list = NULL;
+	bool proto_include = false;
+	char *decap_list = NULL;
 
 	packet = trace_create_packet();
 	if (packet == NULL) {
@@ -420,7 +429,7 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-	while ((opt = getopt(argc, argv, "l:bd:f:RhT")) != EOF) {
+	while ((opt = getopt(argc, argv, "l:bd:f:RhTI:E:D:")) != EOF) {
 		switch (opt) {
 			case 'l':
 				local_mac = optarg;
@@ -445,6 +454,17 @@ int main(int argc, char *argv[])
 			case 'T':
 				dir_method = DIR_METHOD_TRACE;
 				break;
+			case 'I':
+				proto_list = optarg;
+				proto_include = true;
+				break;
+			case 'E':
+				proto_list = optarg;
+				proto_include = false;
+				break;
+			case 'D':
+				decap_list = optarg;
+				break;
 			case 'h':
 			default:
 				usage(argv[0]);
@@ -493,6 +513,13 @@ int main(int argc, char *argv[])
 	if (lpi_init_library() == -1)
 		return -1;
 
+	if (proto_list != NULL && 
+			load_protocol_list(proto_list, proto_include) == -1)
+		return -1;
+
+	if (decap_list != NULL && set_decapsulation(decap_list) == -1)
+		return -1;
+
 	for (i = optind; i < argc; i++) {
 
 		fprintf(stderr, "%s\n", argv[i]);
@@ -0,0 +1,316 @@
+/* 
+ * This file is part of libprotoident
+ *
+ * Copyright (c) 2011 The University of Waikato, Hamilton, New Zealand.
+ * Author: Shane Alcock
+ *
+ * With contributions from:
+ *      Aaron Murrihy
+ *      Donald Neal
+ *
+ * All rights reserved.
+ *
+ * This code has been developed by the University of Waikato WAND 
+ * research group. For further information please see http://www.wand.net.nz/
+ *
+ * libprotoident is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * libprotoident is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libprotoident; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * $Id$
+ */
+
+/* Simple micro-benchmark for the protocol matching engine.
+ *
+ * Rather than reading a trace, this tool builds a handful of synthetic
+ * flows that exercise different parts of the rule set (e.g. flows that
+ * match an early, high priority module vs flows that fall all the way
+ * through to Unknown) and reports the average time taken by
+ * lpi_guess_protocol() for each of them. Run it against two builds of the
+ * library to see what effect a change has had on the matching cost.
+ *
+ * The -b option uses lpi_guess_protocol_batch() instead, classifying many
+ * copies of each flow at once. The -p option hands the flows to a pool of 
+ * worker threads.
+ */
+
+#define __STDC_FORMAT_MACROS
+
+#include <stdio.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include <libprotoident.h>
+
+/* Describes a synthetic flow - payloads are always the first four bytes
+ * of the first payload-bearing packet in each direction, just like the
+ * real thing */
+typedef struct bench_flow {
+	const char *label;
+	uint8_t trans_proto;
+	uint16_t server_port;
+	uint16_t client_port;
+	const char *payload[2];
+	uint32_t payload_len[2];
+} BenchFlow;
+
+static BenchFlow bench_flows[] = {
+	/* Matches one of the first modules we try */
+	{ "http", 6, 80, 51234, { "GET ", "HTTP" }, { 412, 1448 } },
+
+	/* TLS, which many modules check for using match_ssl() */
+	{ "https", 6, 443, 51234, 
+		{ "\x16\x03\x01\x02", "\x16\x03\x03\x00" }, { 517, 1448 } },
+	{ "tls_other_port", 6, 9443, 51234, 
+		{ "\x16\x03\x01\x02", "\x16\x03\x03\x00" }, { 517, 1448 } },
+
+	/* Falls through every TCP / UDP module */
+	{ "unknown_tcp", 6, 40001, 52113,
+		{ "\x8a\x1f\x3c\xd2", "\x51\xe0\x07\x9b" }, { 517, 1380 } },
+	{ "unknown_udp", 17, 40001, 52113,
+		{ "\x8a\x1f\x3c\xd2", "\x51\xe0\x07\x9b" }, { 517, 1380 } },
+
+	/* UDP rules that test bits and length fields within the payload */
+	{ "dns_udp", 17, 53, 51234, 
+		{ "\x1a\x2b\x01\x00", "\x1a\x2b\x81\x80" }, { 40, 56 } },
+	{ "stun", 17, 3478, 51234, 
+		{ "\x00\x01\x00\x08", "\x01\x01\x00\x30" }, { 28, 68 } },
+	{ "skype_udp", 17, 40001, 52113, 
+		{ "\x4e\x21\x02\x41", "\x4e\x21\x02\x97" }, { 30, 65 } },
+	{ "rtp", 17, 16384, 40002, 
+		{ "\x80\x00\x12\x34", "\x80\x00\x56\x78" }, { 172, 172 } },
+
+	/* Only matched by the lowest priority modules */
+	{ "late_tcp", 6, 3128, 51234, { "RXXF", "RXXF" }, { 96, 32 } },
+	{ "late_udp", 17, 40001, 52113,
+		{ "\x05\x03\xff\xff", "\x05\x00\x00\x01" }, { 6, 8 } },
+};
+
+#define BENCH_FLOW_COUNT (sizeof(bench_flows) / sizeof(BenchFlow))
+
+static void build_flow(BenchFlow *bf, lpi_data_t *data) {
+
+	int i;
+
+	lpi_init_data(data);
+
+	data->trans_proto = bf->trans_proto;
+	data->server_port = bf->server_port;
+	data->client_port = bf->client_port;
+
+	for (i = 0; i < 2; i++) {
+		if (bf->payload_len[i] == 0)
+			continue;
+		memcpy(&data->payload[i], bf->payload[i], 4);
+		data->payload_len[i] = bf->payload_len[i];
+		data->observed[i] = bf->payload_len[i];
+	}
+	
+	data->ips[0] = inet_addr("10.0.0.1");
+	data->ips[1] = inet_addr("192.0.2.1");
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+static void run_bench(BenchFlow *bf, uint64_t iterations) {
+
+	lpi_data_t data;
+	lpi_module_t *proto = NULL;
+	uint64_t i;
+	double start, end;
+
+	build_flow(bf, &data);
+
+	/* Warm up the caches before we start timing */
+	for (i = 0; i < 1000; i++)
+		proto = lpi_guess_protocol(&data);
+
+	start = now_ns();
+	for (i = 0; i < iterations; i++)
+		proto = lpi_guess_protocol(&data);
+	end = now_ns();
+
+	printf("%-16s %-20s %10.1f ns/guess\n", bf->label, 
+			proto ? proto->name : "NULL", 
+			(end - start) / (double)iterations);
+}
+
+/* Same as run_bench, but classifies the flows 'batch' at a time using
+ * lpi_guess_protocol_batch() */
+static void run_bench_batch(BenchFlow *bf, uint64_t iterations, 
+		uint32_t batch) {
+
+	lpi_data_t *data;
+	lpi_data_t **flows;
+	lpi_module_t **out;
+	uint64_t i, rounds;
+	uint32_t j;
+	double start, end;
+
+	data = (lpi_data_t *)malloc(sizeof(lpi_data_t) * batch);
+	flows = (lpi_data_t **)malloc(sizeof(lpi_data_t *) * batch);
+	out = (lpi_module_t **)malloc(sizeof(lpi_module_t *) * batch);
+
+	if (data == NULL || flows == NULL || out == NULL) {
+		fprintf(stderr, "Unable to allocate memory for batch\n");
+		exit(1);
+	}
+
+	for (j = 0; j < batch; j++) {
+		build_flow(bf, &data[j]);
+		flows[j] = &data[j];
+	}
+
+	rounds = (iterations + batch - 1) / batch;
+
+	for (i = 0; i < 1000 / batch + 1; i++)
+		lpi_guess_protocol_batch(flows, batch, out);
+
+	start = now_ns();
+	for (i = 0; i < rounds; i++)
+		lpi_guess_protocol_batch(flows, batch, out);
+	end = now_ns();
+
+	printf("%-16s %-20s %10.1f ns/guess\n", bf->label, 
+			out[0] ? out[0]->name : "NULL", 
+			(end - start) / (double)(rounds * batch));
+
+	free(data);
+	free(flows);
+	free(out);
+}
+
+/* Same as run_bench, but hands the flows to a pool of worker threads */
+static void run_bench_pool(BenchFlow *bf, uint64_t iterations, 
+		int threads) {
+
+	lpi_data_t data;
+	lpi_pool_t *pool;
+	lpi_pool_result_t results[256];
+	lpi_pool_stats_t stats;
+	lpi_module_t *proto = NULL;
+	uint64_t submitted = 0, completed = 0;
+	double start, end;
+	int i, n;
+
+	build_flow(bf, &data);
+
+	pool = lpi_pool_create(threads);
+	if (pool == NULL)
+		exit(1);
+
+	/* Every request refers to the same flow, which is fine because the
+	 * workers never modify the LPI data */
+	start = now_ns();
+	while (completed < iterations) {
+		while (submitted < iterations) {
+			if (lpi_pool_submit(pool, &data, NULL) == -1)
+				break;
+			submitted ++;
+		}
+		n = lpi_pool_complete(pool, results, 256);
+		for (i = 0; i < n; i++)
+			proto = results[i].module;
+		completed += n;
+	}
+	end = now_ns();
+
+	lpi_pool_get_stats(pool, &stats, NULL);
+	printf("%-16s %-20s %10.1f ns/guess (%" PRIu64 " rejected)\n", 
+			bf->label, proto ? proto->name : "NULL", 
+			(end - start) / (double)iterations, stats.rejected);
+	lpi_pool_destroy(pool);
+}
+
+static void usage(char *prog) {
+
+	printf("Usage details for %s\n\n", prog);
+	printf("%s [-n <iterations>] [-t <test>] [-b <size>] [-p <threads>] [-c <entries>]\n\n", prog);
+	printf("Options:\n");
+	printf("  -n <iterations>	Number of guesses to time for each test (default 1000000)\n");
+	printf("  -t <test>	Only run the named test\n");
+	printf("  -b <size>	Classify flows in batches of this size using lpi_guess_protocol_batch()\n");
+	printf("  -p <threads>	Classify flows using a pool of worker threads\n");
+	printf("  -c <entries>	Enable the result cache with this many entries\n");
+	printf("\nAvailable tests:\n");
+	for (unsigned int i = 0; i < BENCH_FLOW_COUNT; i++)
+		printf("  %s\n", bench_flows[i].label);
+	exit(0);
+
+}
+
+int main(int argc, char *argv[]) {
+
+	uint64_t iterations = 1000000;
+	char *only = NULL;
+	uint32_t batch = 0;
+	int threads = 0;
+	uint32_t cache_size = 0;
+	unsigned int i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:t:b:p:c:h")) != EOF) {
+		switch (opt) {
+			case 'n':
+				iterations = strtoull(optarg, NULL, 10);
+				break;
+			case 't':
+				only = optarg;
+				break;
+			case 'b':
+				batch = strtoul(optarg, NULL, 10);
+				break;
+			case 'p':
+				threads = atoi(optarg);
+				break;
+			case 'c':
+				cache_size = strtoul(optarg, NULL, 10);
+				break;
+			case 'h':
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	if (iterations == 0)
+		usage(argv[0]);
+
+	if (lpi_init_library() == -1)
+		return -1;
+
+	if (cache_size > 0 && lpi_set_cache_size(cache_size) == -1)
+		return -1;
+
+	for (i = 0; i < BENCH_FLOW_COUNT; i++) {
+		if (only && strcmp(only, bench_flows[i].label) != 0)
+			continue;
+		if (threads > 0)
+			run_bench_pool(&bench_flows[i], iterations, threads);
+		else if (batch > 0)
+			run_bench_batch(&bench_flows[i], iterations, batch);
+		else
+			run_bench(&bench_flows[i], iterations);
+	}
+
+	lpi_free_library();
+	return 0;
+}
@@ -272,8 +272,10 @@ void per_packet(libtrace_packet_t *packet) {
 
 
 	/* Pass the packet into libprotoident so it can extract any info
-	 * it needs from this packet */
-	lpi_update_data(packet, &unk->lpi, dir);
+	 * it needs from this packet. There is no need to keep doing so once
+	 * the LPI data is complete */
+	if (!lpi_data_is_complete(&unk->lpi))
+		lpi_update_data(packet, &unk->lpi, dir);
 
         /* Update TCP state for TCP flows. The TCP state determines how long
 	 * the flow can be idle before being expired by libflowmanager. For
@@ -297,7 +299,7 @@ static void cleanup_signal(int sig) {
 static void usage(char *prog) {
 
 	printf("Usage details for %s\n\n", prog);
-	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] [-H] inputURI [inputURI ...]\n\n", prog);
+	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] [-H] [-I <file>] [-E <file>] [-D <list>] inputURI [inputURI ...]\n\n", prog);
 	printf("Options:\n");
 	printf("  -l <mac>	Determine direction based on <mac> representing the 'inside' \n			portion of the network\n");
 	printf("  -T		Use trace direction tags to determine direction\n");
@@ -306,6 +308,9 @@ static void usage(char *prog) {
 	printf("  -f <filter>	Ignore flows that do not match the given BPF filter\n");
 	printf("  -R 		Ignore flows involving private RFC 1918 address space\n");
 	printf("  -H		Ignore flows that do not meet the criteria for an SPNAT hole\n");
+	printf("  -I <file>	Only try the protocols and categories listed in <file>\n");
+	printf("  -E <file>	Do not try the protocols and categories listed in <file>\n");
+	printf("  -D <list>	Classify the traffic inside the listed tunnels \n			(gre, ipip, vxlan, teredo) rather than the tunnels\n");
 	exit(0);
 
 }
@@ -325,6 +330,9 @@ int main(int argc, char *argv[]) {
 	char *filterstring = NULL;
 	int dir;
 	bool ignore_rfc1918 = false;
+	char *proto_list = NULL;
+	bool proto_include = false;
+	char *decap_list = NULL;
 
         packet = trace_create_packet();
         if (packet == NULL) {
@@ -332,7 +340,7 @@ int main(int argc, char *argv[]) {
                 return -1;
         }
 
-	while ((opt = getopt(argc, argv, "l:bHd:f:RhT")) != EOF) {
+	while ((opt = getopt(argc, argv, "l:bHd:f:RhTI:E:D:")) != EOF) {
                 switch (opt) {
 			case 'l':
 				local_mac = optarg;
@@ -360,6 +368,17 @@ int main(int argc, char *argv[]) {
 			case 'T':
 				dir_method = DIR_METHOD_TRACE;
 				break;
+			case 'I':
+				proto_list = optarg;
+				proto_include = true;
+				break;
+			case 'E':
+				proto_list = optarg;
+				proto_include = false;
+				break;
+			case 'D':
+				decap_list = optarg;
+				break;
                 	case 'h':
 			default:
 				usage(argv[0]);
@@ -410,6 +429,13 @@ int main(int argc, char *argv[]) {
 	if (lpi_init_library() == -1)
 		return -1;
 
+	if (proto_list != NULL && 
+			load_protocol_list(proto_list, proto_include) == -1)
+		return -1;
+
+	if (decap_list != NULL && set_decapsulation(decap_list) == -1)
+		return -1;
+
         for (i = optind; i < argc; i++) {
 
                 fprintf(stderr, "%s\n", argv[i]);
@@ -224,6 +224,7 @@ void init_live_flow(LiveCounters *cnt, Flow *f, uint8_t dir, double ts) {
         lpi_init_data(&live->lpi);
         f->extension = live;
         live->proto = NULL;
+	live->settled = false;
 
 	live->activated_ip = false;
 
@@ -574,8 +575,9 @@ int update_protocol_counters(LiveFlow *live, LiveCounters *cnt, uint32_t wlen,
 
 	/* We only want to ask lpi for the protocol if there is a chance that
 	 * the protocol may have changed. */
-        if (should_guess(live, plen, dir)) {
-                live->proto = lpi_guess_protocol(&live->lpi);
+        if (!live->settled && should_guess(live, plen, dir)) {
+                live->proto = lpi_guess_protocol_ex(&live->lpi, 
+				&live->settled);
         }
 
         if (live->proto == NULL) {
@@ -165,6 +165,9 @@ typedef struct live {
         lpi_data_t lpi;
 	/* The protocol that this flow matches */
         lpi_module_t *proto;
+	/* Set once libprotoident says that the protocol can no longer
+	 * change, so we can stop passing packets to it */
+	bool settled;
 
 	bool activated_ip;
 } LiveFlow;
@@ -180,8 +180,10 @@ void per_packet(libtrace_packet_t *packet) {
 	update_liveflow_stats(live, packet, &counts, dir);
 
 	/* Pass the packet into libprotolive so that it can extract any
-	 * info it needs from this packet */
-	lpi_update_data(packet, &live->lpi, dir);
+	 * info it needs from this packet. Once the LPI data is complete,
+	 * there is nothing more for it to extract */
+	if (!lpi_data_is_complete(&live->lpi))
+		lpi_update_data(packet, &live->lpi, dir);
 
 	if (update_protocol_counters(live, &counts,
 			trace_get_wire_length(packet), 
@@ -215,7 +217,7 @@ static void cleanup_signal(int sig) {
 static void usage(char *prog) {
 
         printf("Usage details for %s\n\n", prog);
-        printf("%s [-i <freq>] [-m <monitor id>] [-l <mac] [-T] [-f <filter>] [-r] [-R] [-H] inputURI [inputURI ...]\n\n", prog);
+        printf("%s [-i <freq>] [-m <monitor id>] [-l <mac] [-T] [-f <filter>] [-r] [-R] [-H] [-I <file>] [-E <file>] [-D <list>] inputURI [inputURI ...]\n\n", prog);
         printf("Options:\n");
 	printf("  -l <mac>      Determine direction based on <mac> representing the 'inside' \n                 portion of the network\n");
 	printf("  -m <id>	Id number to use for this monitor (defaults to $HOSTNAME)\n");
@@ -224,6 +226,9 @@ static void usage(char *prog) {
         printf("  -R            Ignore flows involving private RFC 1918 address space\n");
         printf("  -i <freq>	Report statistics every <freq> seconds\n");
 	printf("  -r		Output results in a format that can be easily used to update an RRD\n");
+	printf("  -I <file>	Only try the protocols and categories listed in <file>\n");
+	printf("  -E <file>	Do not try the protocols and categories listed in <file>\n");
+	printf("  -D <list>	Classify the traffic inside the listed tunnels \n			(gre, ipip, vxlan, teredo) rather than the tunnels\n");
 	exit(0);
 
 }
@@ -244,6 +249,9 @@ int main(int argc, char *argv[]) {
 	char *filterstring = NULL;
 	int dir;
 	bool ignore_rfc1918 = false;
+	char *proto_list = NULL;
+	bool proto_include = false;
+	char *decap_list = NULL;
 
 	double next_report = 0.0;
 
@@ -260,7 +268,7 @@ int main(int argc, char *argv[]) {
                 return -1;
         }
 
-	while ((opt = getopt(argc, argv, "ri:f:Rhl:Tm:")) != EOF) {
+	while ((opt = getopt(argc, argv, "ri:f:Rhl:Tm:I:E:D:")) != EOF) {
                 switch (opt) {
 			case 'l':
                                 local_mac = optarg;
@@ -284,6 +292,17 @@ int main(int argc, char *argv[]) {
 			case 'm':
 				strncpy(local_id, optarg, 256);
 				break;
+			case 'I':
+				proto_list = optarg;
+				proto_include = true;
+				break;
+			case 'E':
+				proto_list = optarg;
+				proto_include = false;
+				break;
+			case 'D':
+				decap_list = optarg;
+				break;
 			case 'h':
 			default:
 				usage(argv[0]);
@@ -332,6 +351,13 @@ int main(int argc, char *argv[]) {
 	if (lpi_init_library() == -1)
 		return -1;
 
+	if (proto_list != NULL && 
+			load_protocol_list(proto_list, proto_include) == -1)
+		return -1;
+
+	if (decap_list != NULL && set_decapsulation(decap_list) == -1)
+		return -1;
+
 	init_live_counters(&counts, false);
 
 	if (optind == argc) {
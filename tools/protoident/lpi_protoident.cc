@@ -42,6 +42,8 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <vector>
+#include <algorithm>
 
 #include <libtrace.h>
 #include <libflowmanager.h>
@@ -268,8 +270,10 @@ void per_packet(libtrace_packet_t *packet) {
 
 
 	/* Pass the packet into libprotoident so it can extract any info
-	 * it needs from this packet */
-	lpi_update_data(packet, &ident->lpi, dir);
+	 * it needs from this packet. There is no need to keep doing so once
+	 * the LPI data is complete */
+	if (!lpi_data_is_complete(&ident->lpi))
+		lpi_update_data(packet, &ident->lpi, dir);
 
         /* Update TCP state for TCP flows. The TCP state determines how long
 	 * the flow can be idle before being expired by libflowmanager. For
@@ -291,10 +295,54 @@ static void cleanup_signal(int sig) {
 	done = 1;
 }
 
+/* Prints the 'count' modules that we spent the most time in, according to
+ * the libprotoident profiler */
+static void print_module_profile(int count) {
+
+	lpi_module_profile_t prof;
+	std::vector<std::pair<uint64_t, int> > costs;
+	int i;
+
+	for (i = 0; i < LPI_PROTO_LAST; i++) {
+		if (lpi_get_module_profile((lpi_protocol_t)i, &prof) == -1)
+			continue;
+		if (prof.calls == 0)
+			continue;
+		costs.push_back(std::make_pair(prof.ticks, i));
+	}
+
+	std::sort(costs.rbegin(), costs.rend());
+
+	fprintf(stderr, "%-24s %12s %12s %16s %12s\n", "Module", "Calls", 
+			"Matches", "Ticks", "Ticks/Call");
+	for (i = 0; i < count && i < (int)costs.size(); i++) {
+		lpi_protocol_t proto = (lpi_protocol_t)costs[i].second;
+
+		lpi_get_module_profile(proto, &prof);
+		fprintf(stderr, "%-24s %12" PRIu64 " %12" PRIu64 " %16" PRIu64 
+				" %12.1f\n", lpi_print(proto), prof.calls, 
+				prof.matches, prof.ticks, 
+				(double)prof.ticks / prof.calls);
+	}
+}
+
+static void print_decap_stats(void) {
+
+	lpi_decap_stats_t stats;
+	int i;
+
+	lpi_get_decap_stats(&stats);
+	for (i = 0; i < LPI_ENCAP_LAST; i++) {
+		fprintf(stderr, "Decapsulated %-8s %12" PRIu64 "\n", 
+				lpi_print_encap((lpi_encap_t)i), 
+				stats.packets[i]);
+	}
+}
+
 static void usage(char *prog) {
 
 	printf("Usage details for %s\n\n", prog);
-	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] [-H] inputURI [inputURI ...]\n\n", prog);
+	printf("%s [-l <mac>] [-T] [-b] [-d <dir>] [-f <filter>] [-R] [-H] [-P <n>] [-I <file>] [-E <file>] [-D <list>] inputURI [inputURI ...]\n\n", prog);
 	printf("Options:\n");
 	printf("  -l <mac>	Determine direction based on <mac> representing the 'inside' \n			portion of the network\n");
 	printf("  -T		Use trace direction tags to determine direction\n");
@@ -303,6 +351,10 @@ static void usage(char *prog) {
 	printf("  -f <filter>	Ignore flows that do not match the given BPF filter\n");
 	printf("  -R 		Ignore flows involving private RFC 1918 address space\n");
 	printf("  -H		Ignore flows that do not meet the criteria for an SPNAT hole\n");
+	printf("  -P <n>		Profile the protocol modules and report the <n> most \n			expensive modules to stderr on exit\n");
+	printf("  -I <file>	Only try the protocols and categories listed in <file>\n");
+	printf("  -E <file>	Do not try the protocols and categories listed in <file>\n");
+	printf("  -D <list>	Classify the traffic inside the listed tunnels \n			(gre, ipip, vxlan, teredo) rather than the tunnels\n");
 	exit(0);
 
 }
@@ -322,6 +374,10 @@ int main(int argc, char *argv[]) {
 	char *filterstring = NULL;
 	int dir;
 	bool ignore_rfc1918 = false;
+	char *proto_list = NULL;
+	bool proto_include = false;
+	char *decap_list = NULL;
+	int profile_count = 0;
 
         packet = trace_create_packet();
         if (packet == NULL) {
@@ -329,7 +385,7 @@ int main(int argc, char *argv[]) {
                 return -1;
         }
 
-	while ((opt = getopt(argc, argv, "l:bHd:f:RhT")) != EOF) {
+	while ((opt = getopt(argc, argv, "l:bHd:f:RhTP:I:E:D:")) != EOF) {
                 switch (opt) {
 			case 'l':
 				local_mac = optarg;
@@ -357,6 +413,20 @@ int main(int argc, char *argv[]) {
 			case 'T':
 				dir_method = DIR_METHOD_TRACE;
 				break;
+			case 'P':
+				profile_count = atoi(optarg);
+				break;
+			case 'I':
+				proto_list = optarg;
+				proto_include = true;
+				break;
+			case 'E':
+				proto_list = optarg;
+				proto_include = false;
+				break;
+			case 'D':
+				decap_list = optarg;
+				break;
                 	case 'h':
 			default:
 				usage(argv[0]);
@@ -407,6 +477,16 @@ int main(int argc, char *argv[]) {
 	if (lpi_init_library() == -1)
 		return -1;
 
+	if (proto_list != NULL && 
+			load_protocol_list(proto_list, proto_include) == -1)
+		return -1;
+
+	if (decap_list != NULL && set_decapsulation(decap_list) == -1)
+		return -1;
+
+	if (profile_count > 0)
+		lpi_set_profiling(true);
+
         for (i = optind; i < argc; i++) {
 
                 fprintf(stderr, "%s\n", argv[i]);
@@ -461,6 +541,11 @@ int main(int argc, char *argv[]) {
         trace_destroy_packet(packet);
         if (!done)
 		expire_ident_flows(ts, true);
+
+	if (profile_count > 0)
+		print_module_profile(profile_count);
+	if (decap_list != NULL)
+		print_decap_stats();
 	lpi_free_library();
 
         return 0;
@@ -34,6 +34,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <libprotoident.h>
 #include "tools_common.h"
 
 int convert_mac_string(char *string, uint8_t *bytes) {
@@ -135,3 +138,147 @@ int port_get_direction(libtrace_packet_t *packet) {
 
 	return dir;
 }
+
+/* Strips leading and trailing whitespace from a string, in place */
+static char *strip_whitespace(char *str) {
+
+	char *end;
+
+	while (isspace((unsigned char)*str))
+		str ++;
+
+	end = str + strlen(str);
+	while (end > str && isspace((unsigned char)*(end - 1)))
+		end --;
+	*end = '\0';
+	return str;
+}
+
+/* Reads a list of protocol and category names from a file, one per line.
+ * Blank lines and anything following a '#' are ignored.
+ *
+ * If 'include' is true, only the listed protocols and the protocols 
+ * belonging to the listed categories will be tried by libprotoident. 
+ * Otherwise, the listed protocols and categories are disabled.
+ *
+ * Must be called after lpi_init_library().
+ */
+int load_protocol_list(const char *filename, bool include) {
+
+	FILE *f;
+	char line[1024];
+	bool listed_proto[LPI_PROTO_LAST];
+	bool listed_cat[LPI_CATEGORY_LAST];
+	uint64_t mask = LPI_CATEGORY_MASK_ALL;
+	int i, linenum = 0;
+
+	memset(listed_proto, 0, sizeof(listed_proto));
+	memset(listed_cat, 0, sizeof(listed_cat));
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		fprintf(stderr, "Unable to open protocol list %s\n", filename);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *name, *comment;
+		lpi_protocol_t proto;
+		bool found = false;
+
+		linenum ++;
+		comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		name = strip_whitespace(line);
+		if (*name == '\0')
+			continue;
+
+		proto = lpi_protocol_by_name(name);
+		if (proto != LPI_PROTO_LAST) {
+			listed_proto[proto] = true;
+			found = true;
+		}
+
+		for (i = 0; i < LPI_CATEGORY_LAST && !found; i++) {
+			if (strcasecmp(name, lpi_print_category(
+					(lpi_category_t)i)) == 0) {
+				listed_cat[i] = true;
+				found = true;
+			}
+		}
+
+		if (!found) {
+			fprintf(stderr, "%s:%d: Unknown protocol or category '%s'\n",
+					filename, linenum, name);
+			fclose(f);
+			return -1;
+		}
+	}
+	fclose(f);
+
+	for (i = 0; i < LPI_PROTO_LAST; i++) {
+		bool enabled;
+
+		if (include) {
+			enabled = listed_proto[i] || listed_cat[
+				lpi_categorise_protocol((lpi_protocol_t)i)];
+		} else {
+			enabled = !listed_proto[i];
+		}
+
+		if (lpi_set_protocol_enabled((lpi_protocol_t)i, enabled) == -1)
+			return -1;
+	}
+
+	if (!include) {
+		for (i = 0; i < LPI_CATEGORY_LAST; i++) {
+			if (listed_cat[i])
+				mask &= ~LPI_CATEGORY_MASK(i);
+		}
+		if (lpi_set_category_mask(mask) == -1)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Parses a comma-separated list of tunnel names, e.g. "gre,vxlan", and 
+ * tells libprotoident to classify the traffic inside those tunnels rather
+ * than the tunnels themselves */
+int set_decapsulation(const char *list) {
+
+	char *copy, *name, *saveptr = NULL;
+	uint32_t mask = 0;
+	int i;
+
+	copy = strdup(list);
+	if (copy == NULL) {
+		fprintf(stderr, "Unable to parse encapsulation list %s\n", list);
+		return -1;
+	}
+
+	for (name = strtok_r(copy, ",", &saveptr); name != NULL; 
+			name = strtok_r(NULL, ",", &saveptr)) {
+		name = strip_whitespace(name);
+		if (*name == '\0')
+			continue;
+
+		for (i = 0; i < LPI_ENCAP_LAST; i++) {
+			if (strcasecmp(name, lpi_print_encap(
+					(lpi_encap_t)i)) == 0)
+				break;
+		}
+
+		if (i == LPI_ENCAP_LAST) {
+			fprintf(stderr, "Unknown encapsulation '%s'\n", name);
+			free(copy);
+			return -1;
+		}
+		mask |= LPI_ENCAP_MASK(i);
+	}
+	free(copy);
+
+	return lpi_set_decapsulation(mask);
+}
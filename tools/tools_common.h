@@ -40,5 +40,7 @@
 int convert_mac_string(char *string, uint8_t *bytes);
 int mac_get_direction(libtrace_packet_t *packet, uint8_t *mac_bytes);
 int port_get_direction(libtrace_packet_t *packet);
+int load_protocol_list(const char *filename, bool include);
+int set_decapsulation(const char *list);
 
 #endif